@@ -0,0 +1,87 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Measure how quickly pikepdf converts Python data to PDF objects
+
+Each case builds a nested structure with about one million leaves and times how
+long pikepdf.Array() takes to convert it, which is the same conversion used when
+assigning Python values to dictionary keys or creating objects with
+Dictionary() and Array().
+"""
+
+import argparse
+import time
+from decimal import Decimal
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark Python to PDF conversion")
+parser.add_argument(
+    '--leaves', type=int, default=1_000_000, help="approximate number of leaves"
+)
+parser.add_argument('--repeat', type=int, default=3, help="best of this many runs")
+
+
+def flat(leaf, n):
+    return [leaf] * n
+
+
+def rows(leaf, n, width=1000):
+    return [[leaf] * width for _ in range(max(1, n // width))]
+
+
+def annotations(n):
+    # Roughly what building many link annotations from Python data looks like
+    return [
+        {
+            '/Type': pikepdf.Name.Annot,
+            '/Subtype': pikepdf.Name.Link,
+            '/Rect': [0, 0, 100.5, 20.25],
+            '/Border': (0, 0, 0),
+        }
+        for _ in range(max(1, n // 7))
+    ]
+
+
+CASES = {
+    'flat ints': lambda n: flat(42, n),
+    'flat floats': lambda n: flat(4.25, n),
+    'flat Decimals': lambda n: flat(Decimal('4.25'), n),
+    'flat strings': lambda n: flat('text', n),
+    'flat Names': lambda n: flat(pikepdf.Name.Text, n),
+    'rows of ints': lambda n: rows(42, n),
+    'annotation dicts': annotations,
+}
+
+
+def main():
+    args = parser.parse_args()
+    for name, make in CASES.items():
+        data = make(args.leaves)
+        best = float('inf')
+        for _ in range(args.repeat):
+            start = time.perf_counter()
+            pikepdf.Array(data)
+            best = min(best, time.perf_counter() - start)
+        print(f"{name:18s} {best * 1000:9.1f} ms")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,100 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compare Pdf.find_objects() with the equivalent loop over Pdf.objects in Python
+
+For each query, the script opens the input file afresh, times the Python loop
+and the native query, checks that they found the same objects and prints the
+speedup. Opening the file is not included in the timings.
+"""
+
+import argparse
+import time
+
+import pikepdf
+from pikepdf import Name, Stream
+
+parser = argparse.ArgumentParser(description="Benchmark Pdf.find_objects()")
+parser.add_argument('input_file')
+parser.add_argument('--repeat', type=int, default=3, help="best of this many runs")
+
+QUERIES = {
+    'images': dict(type=Name.XObject, subtype=Name.Image),
+    'annotations': dict(type=Name.Annot),
+    'flate streams': dict(filter=Name.FlateDecode),
+    'has /Font': dict(has_key=Name.Font),
+}
+
+
+def python_query(pdf, type=None, subtype=None, has_key=None, filter=None):
+    # pylint: disable=redefined-builtin
+    found = []
+    for obj in pdf.objects:
+        if isinstance(obj, Stream):
+            d = obj.stream_dict
+        elif isinstance(obj, pikepdf.Dictionary) and filter is None:
+            d = obj
+        else:
+            continue
+        if type is not None and d.get(Name.Type) != type:
+            continue
+        if subtype is not None and d.get(Name.Subtype) != subtype:
+            continue
+        if has_key is not None and has_key not in d:
+            continue
+        if filter is not None:
+            filters = d.get(Name.Filter)
+            if isinstance(filters, pikepdf.Array):
+                if filter not in filters:
+                    continue
+            elif filters != filter:
+                continue
+        found.append(obj.objgen)
+    return found
+
+
+def native_query(pdf, **query):
+    return [obj.objgen for obj in pdf.find_objects(**query)]
+
+
+def best_time(fn, input_file, query, repeat):
+    best, result = float('inf'), None
+    for _ in range(repeat):
+        with pikepdf.open(input_file) as pdf:
+            start = time.perf_counter()
+            result = fn(pdf, **query)
+            best = min(best, time.perf_counter() - start)
+    return best, result
+
+
+def main():
+    args = parser.parse_args()
+    for label, query in QUERIES.items():
+        t_python, expected = best_time(python_query, args.input_file, query, args.repeat)
+        t_native, found = best_time(native_query, args.input_file, query, args.repeat)
+        assert found == expected, f"{label}: results differ"
+        print(
+            f"{label:>14}: {len(found):7d} objects, python {t_python:8.3f}s, "
+            f"native {t_native:8.3f}s, speedup {t_python / t_native:6.1f}x"
+        )
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,172 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compare Pdf.merge() with a Python loop over pdf.pages.extend()
+
+Writes COUNT copies of a small generated PDF (or of INPUT_FILE, if given) to a
+temporary directory, then merges them into one PDF both ways and prints how long
+each took and the speedup. Both results are saved to memory, so saving cost is
+included, and the page counts are checked to match. Finally the native merge is
+repeated with Pdf.deduplicate() before saving, to show how much output size and
+save time drop when the sources share fonts and images.
+
+The pages.extend() loop keeps every source open until the end, one file
+descriptor each, so the soft limit on open files is raised if needed, and COUNT
+is reduced if the hard limit does not allow it.
+"""
+
+import argparse
+import os
+import tempfile
+import time
+from io import BytesIO
+from pathlib import Path
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark merging many small PDFs")
+parser.add_argument('input_file', nargs='?', help="PDF to merge many copies of")
+parser.add_argument(
+    '--count', type=int, default=1000, help="number of PDFs to merge"
+)
+parser.add_argument(
+    '--workers',
+    type=int,
+    default=os.cpu_count() or 1,
+    help="threads Pdf.merge() uses to open files",
+)
+
+
+def make_sample(path):
+    """Write a two page "invoice" with an embedded font program and a logo"""
+    with pikepdf.new() as pdf:
+        font = pdf.make_indirect(
+            pikepdf.Dictionary(
+                Type=pikepdf.Name.Font,
+                Subtype=pikepdf.Name.TrueType,
+                BaseFont=pikepdf.Name.InvoiceSans,
+                FontDescriptor=pikepdf.Dictionary(
+                    FontFile2=pdf.make_stream(os.urandom(40_000))
+                ),
+            )
+        )
+        logo = pdf.make_stream(
+            os.urandom(30_000),
+            Type=pikepdf.Name.XObject,
+            Subtype=pikepdf.Name.Image,
+            Width=100,
+            Height=100,
+            ColorSpace=pikepdf.Name.DeviceRGB,
+            BitsPerComponent=8,
+        )
+        for n in range(2):
+            page = pdf.add_blank_page()
+            page.Resources = pikepdf.Dictionary(
+                Font=pikepdf.Dictionary(F1=font), XObject=pikepdf.Dictionary(Im0=logo)
+            )
+            page.Contents = pdf.make_stream(
+                f"/Im0 Do BT /F1 24 Tf 72 720 Td (Invoice page {n + 1}) Tj ET".encode()
+            )
+        pdf.save(path)
+
+
+def files_we_can_open(count, spare=64):
+    """Return how many of count files can be held open at once"""
+    try:
+        import resource
+    except ImportError:  # Not available on Windows
+        return count
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    wanted = count + spare
+    if soft != resource.RLIM_INFINITY and soft < wanted:
+        soft = wanted if hard == resource.RLIM_INFINITY else min(wanted, hard)
+        resource.setrlimit(resource.RLIMIT_NOFILE, (soft, hard))
+    if soft != resource.RLIM_INFINITY and soft < wanted:
+        return max(1, soft - spare)
+    return count
+
+
+def merge_with_extend(paths):
+    sources = []
+    with pikepdf.new() as output:
+        for path in paths:
+            src = pikepdf.open(path)
+            output.pages.extend(src.pages)
+            sources.append(src)
+        output.save(BytesIO())
+        page_count = len(output.pages)
+    for src in sources:
+        src.close()
+    return page_count
+
+
+def merge_native(paths, workers, deduplicate=False):
+    with pikepdf.new() as output:
+        output.merge(paths, workers=workers)
+        saved = output.deduplicate() if deduplicate else 0
+        start = time.perf_counter()
+        output_file = BytesIO()
+        output.save(output_file)
+        save_time = time.perf_counter() - start
+        return len(output.pages), len(output_file.getvalue()), save_time, saved
+
+
+def timed(fn, *args):
+    start = time.perf_counter()
+    result = fn(*args)
+    return result, time.perf_counter() - start
+
+
+def main():
+    args = parser.parse_args()
+    count = files_we_can_open(args.count)
+    if count < args.count:
+        print(f"open file limit allows merging {count} files, not {args.count}")
+        args.count = count
+    with tempfile.TemporaryDirectory() as tmpdir:
+        sample = Path(tmpdir) / 'sample.pdf'
+        if args.input_file:
+            sample.write_bytes(Path(args.input_file).read_bytes())
+        else:
+            make_sample(sample)
+        paths = []
+        for n in range(args.count):
+            path = Path(tmpdir) / f'{n:05d}.pdf'
+            path.write_bytes(sample.read_bytes())
+            paths.append(path)
+
+        loop_pages, loop_time = timed(merge_with_extend, paths)
+        native, native_time = timed(merge_native, paths, args.workers)
+        dedup, dedup_time = timed(merge_native, paths, args.workers, True)
+        native_pages = native[0]
+        assert loop_pages == native_pages == dedup[0]
+
+    print(f"merged {args.count} files, {native_pages} pages")
+    print(f"pages.extend() loop: {loop_time:8.3f} s")
+    print(f"Pdf.merge():         {native_time:8.3f} s")
+    print(f"speedup {loop_time / native_time:5.1f}x")
+    print(f"Pdf.merge() + deduplicate(): {dedup_time:8.3f} s")
+    print(f"deduplicate() reported {dedup[3]} bytes saved")
+    print(f"output size: {native[1]:12d} -> {dedup[1]:12d} bytes")
+    print(f"save time:   {native[2]:12.3f} -> {dedup[2]:12.3f} s")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,91 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compare pikepdf.probe() with opening a PDF fully to read the same facts
+
+Both approaches report the page count, PDF version, encryption status, document
+information and XMP metadata. The script prints the best time of each and how
+much each grew the process's peak resident set size (POSIX only).
+"""
+
+import argparse
+import resource
+import time
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark pikepdf.probe()")
+parser.add_argument('input_file')
+parser.add_argument('--repeat', type=int, default=5, help="best of this many runs")
+
+
+def full_open(path):
+    with pikepdf.open(path) as pdf:
+        return (
+            len(pdf.pages),
+            pdf.pdf_version,
+            pdf.is_encrypted,
+            {k: str(v) for k, v in pdf.trailer.get('/Info', {}).items()},
+            pdf.Root.Metadata.read_bytes() if '/Metadata' in pdf.Root else None,
+        )
+
+
+def probe(path):
+    info = pikepdf.probe(path)
+    return (
+        info.page_count,
+        info.pdf_version,
+        info.is_encrypted,
+        info.docinfo,
+        info.xmp,
+    )
+
+
+def best_time(fn, path, repeat):
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn(path)
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def max_rss():
+    # ru_maxrss is in KiB on Linux and bytes on macOS
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+
+def main():
+    args = parser.parse_args()
+    # Probe first, so that the full open's memory growth is not hidden
+    rss_start = max_rss()
+    t_probe = best_time(probe, args.input_file, args.repeat)
+    rss_probe = max_rss()
+    t_open = best_time(full_open, args.input_file, args.repeat)
+    rss_open = max_rss()
+
+    print(f"probe:     {t_probe * 1000:10.2f} ms, peak RSS +{rss_probe - rss_start}")
+    print(f"full open: {t_open * 1000:10.2f} ms, peak RSS +{rss_open - rss_probe}")
+    print(f"speedup:   {t_open / t_probe:10.1f}x")
+    print(probe(args.input_file)[:3])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,129 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Measure Pdf.save() throughput for each kind of output
+
+The input file is opened once and saved repeatedly to:
+
+- a filename, and an open regular file, which are written through the file
+  descriptor without the GIL;
+- an io.BytesIO, which is written through stream.write() in blocks of the save
+  buffer size;
+- a file-like object that counts write() calls, showing how many times the
+  save had to call back into Python.
+
+Each output is timed for several save buffer sizes, and the best of a few runs
+is reported in MB/s of output.
+"""
+
+import argparse
+import tempfile
+import time
+from io import BytesIO
+from pathlib import Path
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark Pdf.save() output paths")
+parser.add_argument('input_file')
+parser.add_argument('--repeat', type=int, default=5, help="best of this many runs")
+parser.add_argument(
+    '--buffer-sizes',
+    type=int,
+    nargs='+',
+    default=[4096, 65536, 1 << 20],
+    help="save buffer sizes to try, in bytes",
+)
+
+
+class CountingWriter:
+    """A file-like object without fileno(), so saves must call write()"""
+
+    def __init__(self):
+        self.writes = 0
+        self.size = 0
+
+    def write(self, data):
+        self.writes += 1
+        self.size += len(data)
+        return len(data)
+
+    def flush(self):
+        pass
+
+    def tell(self):
+        return self.size
+
+
+def best_time(save, repeat):
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.perf_counter()
+        save()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main():
+    args = parser.parse_args()
+    original_buffer_size = pikepdf._qpdf.get_save_buffer_size()
+    with pikepdf.open(args.input_file) as pdf, tempfile.TemporaryDirectory() as tmp:
+        target = Path(tmp) / 'output.pdf'
+
+        def to_filename():
+            pdf.save(target)
+
+        def to_file_object():
+            with open(target, 'wb') as f:
+                pdf.save(f)
+
+        def to_bytesio():
+            pdf.save(BytesIO())
+
+        counter = CountingWriter()
+
+        def to_counting_writer():
+            pdf.save(counter)
+
+        outputs = [
+            ('filename', to_filename),
+            ('open file', to_file_object),
+            ('BytesIO', to_bytesio),
+            ('write() only', to_counting_writer),
+        ]
+        pdf.save(target)
+        size_mb = target.stat().st_size / 1e6
+        try:
+            for buffer_size in args.buffer_sizes:
+                pikepdf._qpdf.set_save_buffer_size(buffer_size)
+                print(f"save buffer {buffer_size} bytes:")
+                for name, save in outputs:
+                    counter.writes = 0
+                    elapsed = best_time(save, args.repeat)
+                    line = f"  {name:14s} {size_mb / elapsed:8.1f} MB/s"
+                    if save is to_counting_writer:
+                        line += f", {counter.writes // args.repeat} write() calls"
+                    print(line)
+        finally:
+            pikepdf._qpdf.set_save_buffer_size(original_buffer_size)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,83 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compare Pdf.save(workers=N) with an ordinary save
+
+For each worker count, the script opens the input file afresh and saves it to
+memory with recompress_flate=True, so that every Flate stream is compressed
+again. It prints the best save time, the output size and the speedup over an
+ordinary save, and checks that the output is the same for every worker count.
+"""
+
+import argparse
+import os
+import time
+from io import BytesIO
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark Pdf.save(workers=N)")
+parser.add_argument('input_file')
+parser.add_argument(
+    '--workers',
+    type=int,
+    default=os.cpu_count() or 1,
+    help="largest number of workers to try",
+)
+parser.add_argument('--repeat', type=int, default=3, help="best of this many runs")
+parser.add_argument(
+    '--level', type=int, default=-1, help="Flate compression level, -1 to 9"
+)
+
+
+def best_save(input_file, workers, repeat):
+    best, output = float('inf'), None
+    for _ in range(repeat):
+        with pikepdf.open(input_file) as pdf:
+            out = BytesIO()
+            start = time.perf_counter()
+            pdf.save(out, static_id=True, recompress_flate=True, workers=workers)
+            best = min(best, time.perf_counter() - start)
+            output = out.getvalue()
+    return best, output
+
+
+def main():
+    args = parser.parse_args()
+    pikepdf._qpdf.set_flate_compression_level(args.level)
+
+    baseline, output = best_save(args.input_file, None, args.repeat)
+    print(f"   ordinary save: {baseline:8.3f}s, {len(output):11d} bytes")
+
+    reference = None
+    worker_counts = sorted({1, 2, 4, 8, 16, args.workers})
+    for workers in (n for n in worker_counts if n <= args.workers):
+        elapsed, output = best_save(args.input_file, workers, args.repeat)
+        if reference is None:
+            reference = output
+        assert output == reference, f"output differs with {workers} workers"
+        print(
+            f"{workers:4d} workers: {elapsed:8.3f}s, {len(output):11d} bytes, "
+            f"speedup {baseline / elapsed:5.2f}x"
+        )
+
+
+if __name__ == '__main__':
+    main()
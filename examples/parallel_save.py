@@ -0,0 +1,95 @@
+# Copyright (c) 2021, James R. Barlow
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Save PDFs from several Python threads at once, and report how well it scales
+
+Pdf.save() holds the GIL until it returns, so threads that save different PDFs
+take turns; compare with the save's own workers argument. For each thread count,
+every thread opens its own copy of the input file and saves it repeatedly to its
+own temporary file; the script prints the total throughput and the speedup over a
+single thread.
+"""
+
+import argparse
+import os
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+import pikepdf
+
+parser = argparse.ArgumentParser(description="Benchmark saving PDFs from threads")
+parser.add_argument('input_file')
+parser.add_argument(
+    '--threads',
+    type=int,
+    default=os.cpu_count() or 1,
+    help="largest number of threads to try",
+)
+parser.add_argument(
+    '--saves', type=int, default=20, help="number of saves per thread"
+)
+parser.add_argument(
+    '--recompress-flate',
+    action='store_true',
+    help="recompress Flate streams, which makes each save CPU-bound",
+)
+
+
+def save_repeatedly(input_file, output_file, saves, recompress_flate):
+    with pikepdf.open(input_file) as pdf:
+        for _ in range(saves):
+            pdf.save(output_file, recompress_flate=recompress_flate)
+
+
+def main():
+    args = parser.parse_args()
+    baseline = None
+    thread_counts = sorted({1, 2, 4, 8, 16, args.threads})
+    for threads in (n for n in thread_counts if n <= args.threads):
+        start = time.perf_counter()
+        with ThreadPoolExecutor(
+            max_workers=threads
+        ) as executor, tempfile.TemporaryDirectory() as tmpdir:
+            futures = [
+                executor.submit(
+                    save_repeatedly,
+                    args.input_file,
+                    Path(tmpdir) / f'{n}.pdf',
+                    args.saves,
+                    args.recompress_flate,
+                )
+                for n in range(threads)
+            ]
+            for future in futures:
+                future.result()
+        elapsed = time.perf_counter() - start
+        rate = threads * args.saves / elapsed
+        if baseline is None:
+            baseline = rate
+        print(
+            f"{threads:3d} threads: {rate:8.1f} saves/s, "
+            f"speedup {rate / baseline:5.2f}x"
+        )
+
+
+if __name__ == '__main__':
+    main()
@@ -24,6 +24,7 @@ from ._qpdf import (
     AccessMode,
     Annotation,
     AttachedFileSpec,
+    ContentRules,
     DataDecodingError,
     ForeignObjectError,
     NameTree,
@@ -66,6 +67,9 @@ from .models import (
     unparse_content_stream,
 )
 
+from ._batch import OpenResult, open_many
+from ._probe import ProbeResult, probe
+
 from . import _methods, codec
 
 # While _cpphelpers is intended to be called from our C++ code only, explicitly
@@ -0,0 +1,110 @@
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+
+"""Open many PDFs at once on native worker threads."""
+
+import os
+from pathlib import Path
+from typing import Iterable, Iterator, NamedTuple, Optional, Union
+
+from ._qpdf import Pdf, _BatchOpener
+
+
+class OpenResult(NamedTuple):
+    """The outcome of opening one file with :func:`pikepdf.open_many`."""
+
+    path: Union[Path, str]
+    """The path, as it was given to :func:`pikepdf.open_many`."""
+
+    pdf: Optional[Pdf]
+    """The opened PDF, or ``None`` if it could not be opened."""
+
+    error: Optional[Exception]
+    """The exception that opening the file raised, or ``None``."""
+
+
+def open_many(
+    paths: Iterable[Union[Path, str]],
+    *,
+    workers: Optional[int] = None,
+    password: Union[str, bytes] = "",
+    hex_password: bool = False,
+    ignore_xref_streams: bool = False,
+    suppress_warnings: bool = True,
+    attempt_recovery: bool = True,
+    inherit_page_attributes: bool = True,
+    check: bool = False,
+) -> Iterator[OpenResult]:
+    """
+    Open many PDFs in parallel, yielding each one as soon as it is ready.
+
+    The files are opened on a pool of native threads that do not hold the
+    Python GIL, so parsing, xref recovery and (if requested) stream decoding
+    can use several CPU cores. Results are yielded in the order the files finish,
+    which is not necessarily the order of *paths*. A file that cannot be opened
+    does not stop the batch; its result has ``pdf=None`` and the exception that
+    :meth:`pikepdf.Pdf.open` would have raised in ``error``.
+
+    Files are opened at most ``2 * workers`` ahead of the results that have been
+    consumed, so a slow consumer does not cause every file to be held open at
+    once. If the iterator is closed early, files that have not been started are
+    skipped and those in progress are discarded.
+
+    Examples:
+
+        >>> for result in pikepdf.open_many(paths, workers=8, check=True):
+                if result.error:
+                    print(result.path, result.error)
+                else:
+                    with result.pdf as pdf:
+                        ...
+
+    Args:
+        paths: Filenames of PDFs to open. Streams are not supported.
+        workers: Number of threads to use. Defaults to the number of CPUs.
+        password: Password to try on every file. See :meth:`pikepdf.Pdf.open`.
+        hex_password: See :meth:`pikepdf.Pdf.open`.
+        ignore_xref_streams: See :meth:`pikepdf.Pdf.open`.
+        suppress_warnings: See :meth:`pikepdf.Pdf.open`.
+        attempt_recovery: See :meth:`pikepdf.Pdf.open`.
+        inherit_page_attributes: See :meth:`pikepdf.Pdf.open`.
+        check: If True, also decode every stream in each file and discard the
+            result, as :meth:`pikepdf.Pdf.check` does. Streams that cannot be
+            decoded are reported by :meth:`pikepdf.Pdf.get_warnings`.
+
+    .. versionadded:: 3.0
+    """
+    paths = list(paths)
+    if workers is None:
+        workers = os.cpu_count() or 1
+    if isinstance(password, str):
+        password = password.encode('utf-8')
+
+    batch = _BatchOpener(
+        [os.fsencode(p) for p in paths],
+        workers,
+        password=password,
+        hex_password=hex_password,
+        ignore_xref_streams=ignore_xref_streams,
+        suppress_warnings=suppress_warnings,
+        attempt_recovery=attempt_recovery,
+        inherit_page_attributes=inherit_page_attributes,
+        decode_streams=check,
+    )
+    try:
+        for index, pdf in batch:
+            error = None
+            if pdf is None:
+                try:
+                    batch._rethrow(index)
+                except Exception as e:  # pylint: disable=broad-except
+                    error = e
+            else:
+                setattr(pdf, '_tmp_stream', None)
+                setattr(pdf, '_original_filename', False)
+            yield OpenResult(paths[index], pdf, error)
+    finally:
+        batch.close()
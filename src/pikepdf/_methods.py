@@ -15,19 +15,21 @@ We can also move the implementation to C++ if desired.
 import datetime
 import inspect
 import mimetypes
+import os
 import platform
 import shutil
 from collections.abc import KeysView, MutableMapping
 from decimal import Decimal
-from io import BytesIO
+from io import BytesIO, RawIOBase
 from pathlib import Path
 from subprocess import PIPE, run
-from tempfile import NamedTemporaryFile
+from tempfile import NamedTemporaryFile, SpooledTemporaryFile
 from typing import (
     Any,
     BinaryIO,
     Callable,
     ItemsView,
+    Iterable,
     Iterator,
     List,
     Optional,
@@ -195,6 +197,153 @@ def _mudraw(buffer, fmt) -> bytes:
         return proc.stdout
 
 
+def _check_filter_decode_parms(filter, decode_parms):  # pylint: disable=redefined-builtin
+    if isinstance(filter, list):
+        filter = Array(filter)
+    filter = filter.wrap_in_array()
+
+    if isinstance(decode_parms, list):
+        decode_parms = Array(decode_parms)
+    elif decode_parms is None:
+        decode_parms = Array([])
+    else:
+        decode_parms = decode_parms.wrap_in_array()
+
+    if not all(isinstance(item, Name) for item in filter):
+        raise TypeError("filter must be: pikepdf.Name or pikepdf.Array([pikepdf.Name])")
+    if not all((isinstance(item, Dictionary) or item is None) for item in decode_parms):
+        raise TypeError(
+            "decode_parms must be: pikepdf.Dictionary or "
+            "pikepdf.Array([pikepdf.Dictionary])"
+        )
+    if len(decode_parms) != 0:
+        if len(filter) != len(decode_parms):
+            raise ValueError(
+                f"filter ({repr(filter)}) and decode_parms "
+                f"({repr(decode_parms)}) must be arrays of same length"
+            )
+    if len(filter) == 1:
+        filter = filter[0]
+    if len(decode_parms) == 0:
+        decode_parms = None
+    elif len(decode_parms) == 1:
+        decode_parms = decode_parms[0]
+    return filter, decode_parms
+
+
+_STREAM_DATA_CHUNK_SIZE = 1024 * 1024
+
+
+def _stream_data_factory(source) -> Callable[[], Iterable[bytes]]:
+    """Return a callable that produces the data of *source* in chunks, afresh
+    each time it is called."""
+
+    def read_chunks(f):
+        while True:
+            chunk = f.read(_STREAM_DATA_CHUNK_SIZE)
+            if not chunk:
+                return
+            yield chunk
+
+    if isinstance(source, (bytes, bytearray, memoryview)):
+        raise TypeError("write_from() needs a source of data; use write() for bytes")
+    if isinstance(source, str) or hasattr(source, '__fspath__'):
+        path = Path(os.fspath(source))
+
+        def from_path():
+            with path.open('rb') as f:
+                yield from read_chunks(f)
+
+        return from_path
+
+    if hasattr(source, 'read') and hasattr(source, 'seek'):
+        start = source.tell()
+
+        def from_file():
+            source.seek(start)
+            yield from read_chunks(source)
+
+        return from_file
+
+    if callable(source):
+        return source
+
+    iterator = iter(source)
+    used = False
+
+    def from_iterator():
+        nonlocal used
+        if used:
+            raise RuntimeError(
+                "Stream data from an iterator can only be read once; use a filename, "
+                "file or callable as the source instead"
+            )
+        used = True
+        return iterator
+
+    return from_iterator
+
+
+class StreamReader(RawIOBase):
+    """A read-only binary file of decoded stream data.
+
+    Returned by :meth:`pikepdf.Object.open_reader`. Iterating yields the data in
+    chunks of *chunk_size* bytes, rather than in lines.
+    """
+
+    def __init__(self, spool, chunk_size: int):
+        super().__init__()
+        self._spool = spool
+        self._chunk_size = chunk_size
+
+    def readable(self) -> bool:
+        return True
+
+    def seekable(self) -> bool:
+        return True
+
+    def readinto(self, b) -> int:
+        data = self._spool.read(len(b))
+        b[: len(data)] = data
+        return len(data)
+
+    def seek(self, offset: int, whence: int = 0) -> int:
+        return self._spool.seek(offset, whence)
+
+    def tell(self) -> int:
+        return self._spool.tell()
+
+    def close(self) -> None:
+        if not self.closed:
+            self._spool.close()
+        super().close()
+
+    def __iter__(self) -> Iterator[bytes]:
+        while True:
+            chunk = self.read(self._chunk_size)
+            if not chunk:
+                return
+            yield chunk
+
+
+def _open_stream_reader(
+    obj: Object,
+    chunk_size: int,
+    decode_level: StreamDecodeLevel,
+    spool_size: int,
+) -> StreamReader:
+    if chunk_size < 1:
+        raise ValueError("chunk_size must be at least 1")
+    spool = SpooledTemporaryFile(max_size=spool_size)
+    try:
+        obj._pipe_stream_data(spool, decode_level=decode_level)
+        spool.seek(0)
+    except BaseException:
+        spool.close()
+        raise
+    return StreamReader(spool, chunk_size)
+
+
 @augments(Object)
 class Extend_Object:
     def _ipython_key_completions_(self):
@@ -291,42 +440,81 @@ class Extend_Object:
         """
 
         if type_check and filter is not None:
-            if isinstance(filter, list):
-                filter = Array(filter)
-            filter = filter.wrap_in_array()
-
-            if isinstance(decode_parms, list):
-                decode_parms = Array(decode_parms)
-            elif decode_parms is None:
-                decode_parms = Array([])
-            else:
-                decode_parms = decode_parms.wrap_in_array()
-
-            if not all(isinstance(item, Name) for item in filter):
-                raise TypeError(
-                    "filter must be: pikepdf.Name or pikepdf.Array([pikepdf.Name])"
-                )
-            if not all(
-                (isinstance(item, Dictionary) or item is None) for item in decode_parms
-            ):
-                raise TypeError(
-                    "decode_parms must be: pikepdf.Dictionary or "
-                    "pikepdf.Array([pikepdf.Dictionary])"
-                )
-            if len(decode_parms) != 0:
-                if len(filter) != len(decode_parms):
-                    raise ValueError(
-                        f"filter ({repr(filter)}) and decode_parms "
-                        f"({repr(decode_parms)}) must be arrays of same length"
-                    )
-            if len(filter) == 1:
-                filter = filter[0]
-            if len(decode_parms) == 0:
-                decode_parms = None
-            elif len(decode_parms) == 1:
-                decode_parms = decode_parms[0]
+            filter, decode_parms = _check_filter_decode_parms(filter, decode_parms)
         self._write(data, filter=filter, decode_parms=decode_parms)
 
+    def write_from(
+        self,
+        source: Union[Path, str, BinaryIO, Callable[[], Iterable[bytes]], Iterable[bytes]],
+        *,
+        filter: Union[Name, Array, None] = None,
+        decode_parms: Union[Dictionary, Array, None] = None,
+        type_check: bool = True,
+    ):  # pylint: disable=redefined-builtin
+        """
+        Replace stream object's data with data that is read when it is needed.
+
+        Unlike :meth:`write`, the data is not loaded into memory now. Instead it
+        is read from *source* in chunks whenever pikepdf needs it, usually while
+        saving. This makes it possible to embed very large files.
+
+        *source* may be:
+
+        * a filename, which is opened, read and closed each time the data is needed;
+        * a seekable binary file, which is read from its current position each
+          time the data is needed; the file must remain open until the ``Pdf`` is
+          saved;
+        * a callable that returns an iterable of bytes-like chunks, which is called
+          each time the data is needed;
+        * an iterable of bytes-like chunks, which can only be read once. Saving
+          may need the data more than once (for example, when linearizing), so
+          prefer one of the other types.
+
+        *filter*, *decode_parms* and *type_check* have the same meaning as for
+        :meth:`write`.
+
+        .. versionadded:: 3.0
+        """
+        if type_check and filter is not None:
+            filter, decode_parms = _check_filter_decode_parms(filter, decode_parms)
+        self._write_from_provider(
+            _stream_data_factory(source), filter=filter, decode_parms=decode_parms
+        )
+
+    def open_reader(
+        self,
+        *,
+        chunk_size: int = 64 * 1024,
+        decode_level: StreamDecodeLevel = StreamDecodeLevel.generalized,
+        spool_size: int = 4 * 1024 * 1024,
+    ) -> StreamReader:
+        """
+        Open this stream's decoded data as a read-only binary file.
+
+        Unlike :meth:`read_bytes`, this does not hold all of the decoded data in
+        memory. The stream is decoded into a spool that is kept in memory up to
+        *spool_size* bytes and moved to a temporary file beyond that. The returned
+        file can be read like any other, or iterated to obtain the data in chunks
+        of *chunk_size* bytes. Close it, or use it in a ``with`` block, to release
+        the spool.
+
+        The stream is decoded when this function is called, so later changes to
+        the stream are not reflected in the reader.
+
+        Example:
+            >>> with pdf.attachments['video.mp4'].get_file().open_reader() as r:
+                    for chunk in r:
+                        output.write(chunk)
+
+        Args:
+            chunk_size: Size of the chunks yielded when iterating the reader.
+            decode_level: How much to decode the stream, as for :meth:`read_bytes`.
+            spool_size: Largest amount of decoded data to keep in memory.
+
+        .. versionadded:: 3.0
+        """
+        return _open_stream_reader(self, chunk_size, decode_level, spool_size)
+
 
 @augments(Pdf)
 class Extend_Pdf:
@@ -475,6 +663,46 @@ class Extend_Pdf:
         """
         return Outline(self, max_depth=max_depth, strict=strict)
 
+    def find_objects(
+        self,
+        *,
+        type: Union[Name, str, None] = None,  # pylint: disable=redefined-builtin
+        subtype: Union[Name, str, None] = None,
+        has_key: Union[Name, str, Iterable[Union[Name, str]], None] = None,
+        filter: Union[Name, str, None] = None,  # pylint: disable=redefined-builtin
+    ) -> List[Object]:
+        """
+        Find all dictionaries and streams that match every given criterion.
+
+        The search runs in C++ over :attr:`Pdf.objects`, so only the matching
+        objects are returned to Python.
+
+        Args:
+            type: Value of ``/Type``, such as ``Name.XObject``.
+            subtype: Value of ``/Subtype``, such as ``Name.Image``.
+            has_key: A key, or several keys, that must all be present.
+            filter: A stream filter such as ``Name.DCTDecode`` that must be
+                ``/Filter`` or one of the filters in it. Only streams are
+                returned.
+
+        Example:
+
+            >>> images = pdf.find_objects(type=Name.XObject, subtype=Name.Image)
+
+        .. versionadded:: 3.0
+        """
+
+        def name(value) -> str:
+            return str(Name(value)) if value is not None else ''
+
+        if has_key is None:
+            keys = []
+        elif isinstance(has_key, (str, Name)):
+            keys = [name(has_key)]
+        else:
+            keys = [name(key) for key in has_key]
+        return self.objects._find(name(type), name(subtype), keys, name(filter))
+
     def make_stream(self, data: bytes, d=None, **kwargs) -> Stream:
         """
         Create a new pikepdf.Stream object that is attached to this PDF.
@@ -570,9 +798,24 @@ class Extend_Pdf:
         """
         return EncryptionInfo(self._encryption_data)
 
-    def check(self) -> List[str]:
+    def check(self, *, workers: int = 1) -> List[str]:
         """
         Check if PDF is well-formed.  Similar to ``qpdf --check``.
+
+        .. warning::
+
+            With ``workers`` greater than 1, streams are checked in the file on
+            disk that this Pdf was opened from, not in memory. Any changes made
+            to the Pdf since it was opened are ignored. Encrypted files and
+            Pdfs not opened from a file are always checked in memory, on one
+            thread.
+
+        Args:
+            workers: Number of threads to use to decode streams. See the warning
+                above.
+
+        .. versionchanged:: 3.0
+            Added the *workers* argument.
         """
 
         class DiscardingParser(StreamParser):
@@ -587,7 +830,10 @@ class Extend_Pdf:
 
         problems: List[str] = []
 
-        self._decode_all_streams_and_discard()
+        if workers > 1 and self._has_source_file:
+            self._decode_streams_parallel(workers)
+        else:
+            self._decode_all_streams_and_discard()
 
         discarding_parser = DiscardingParser()
         for page in self.pages:
@@ -598,6 +844,67 @@ class Extend_Pdf:
 
         return problems
 
+    def merge(
+        self,
+        sources: Iterable[Union['Pdf', Path, str]],
+        *,
+        workers: Optional[int] = None,
+        password: Union[str, bytes] = "",
+        hex_password: bool = False,
+        attempt_recovery: bool = True,
+    ) -> int:
+        """
+        Append all pages of each source to this Pdf, in order.
+
+        This is equivalent to ``pdf.pages.extend(src.pages)`` for each source, but
+        much faster when there are many sources, because pages are copied
+        natively and the page tree is updated once at the end. Sources given as
+        paths are opened on background threads while earlier sources are copied.
+        The stream data of files up to 8 MiB is copied into memory and the file
+        is closed. Larger files are kept open for as long as this Pdf, since the
+        copied pages read their stream data from them, so each one uses a file
+        descriptor until this Pdf is closed; merging thousands of large files at
+        once may exceed the operating system's limit on open files.
+
+        Args:
+            sources: Pdfs, or paths of PDFs to open. Each source is read once;
+                a path named twice is opened twice. Pages of a Pdf that were
+                already copied into this one, by an earlier source or by
+                ``pages.extend()``, are added again as new page objects that
+                share their content and resources.
+            workers: Number of threads used to open sources given as paths.
+                Defaults to the number of CPUs.
+            password: Password for sources that are encrypted; see
+                :meth:`pikepdf.open`. Warnings raised while opening are
+                suppressed.
+            hex_password: See :meth:`pikepdf.open`.
+            attempt_recovery: See :meth:`pikepdf.open`.
+
+        Returns:
+            The number of pages added.
+
+        Raises:
+            pikepdf.PdfError: If a source could not be opened or copied. No pages
+                are added to this Pdf in that case.
+
+        Each source brings its own copy of fonts and other resources. Call
+        :meth:`deduplicate` afterwards to share identical copies.
+
+        .. versionadded:: 3.0
+        """
+        if workers is None:
+            workers = os.cpu_count() or 1
+        if isinstance(password, str):
+            password = password.encode('utf-8')
+        items = [src if isinstance(src, Pdf) else os.fsencode(src) for src in sources]
+        return self._merge(
+            items,
+            workers=workers,
+            password=password,
+            hex_password=hex_password,
+            attempt_recovery=attempt_recovery,
+        )
+
     def save(
         self,
         filename_or_stream: Union[Path, str, BinaryIO, None] = None,
@@ -616,6 +923,9 @@ class Extend_Pdf:
         progress: Callable[[int], None] = None,
         encryption: Optional[Union[Encryption, bool]] = None,
         recompress_flate: bool = False,
+        workers: Optional[int] = None,
+        incremental: bool = False,
+        deduplicate: bool = False,
     ) -> None:
         """
         Save all modifications to this :class:`pikepdf.Pdf`.
@@ -681,6 +991,40 @@ class Extend_Pdf:
                 do this, which may be useful if recompressing streams to a
                 higher compression level.
 
+            workers: If set, streams are Flate-compressed on this many
+                threads before the file is written, instead of one at a time
+                while writing. The output does not depend on the number of
+                workers, and the compression level set with
+                ``pikepdf._qpdf.set_flate_compression_level()`` is used. The
+                compressed data is held in memory until the file is written,
+                then the streams get their original data back. Streams that
+                cannot be decoded at *stream_decode_level*, streams larger
+                than 64 MiB and streams copied from other PDFs are left to
+                qpdf as usual. The output is equivalent to, but not byte for
+                byte the same as, a save without *workers*: keys such as
+                ``/Filter`` and ``/DecodeParms`` may appear in a different
+                order in stream dictionaries.
+                Cannot be combined with *encryption*, *normalize_content* or
+                *qdf*. Has no effect if *compress_streams* is ``False``.
+
+            incremental: If ``True``, the file this ``Pdf`` was opened from is
+                copied unchanged to the output, and only the objects that were
+                created or modified since are appended to it, followed by a new
+                cross-reference section. This is much faster than a full save
+                when a small change is made to a large file, and saving to the
+                input file itself only appends to it. The ``Pdf`` must have been
+                opened from a file and must not be encrypted. Options that
+                control how objects are written are ignored; *linearize*,
+                *qdf*, *normalize_content*, *encryption* and *workers* cannot
+                be used. To find the changes, every object is compared with
+                the file on disk, so the time taken grows with the number of
+                objects in the file rather than the number of changes, though
+                stream data is only read for streams that changed.
+
+            deduplicate: If ``True``, call :meth:`deduplicate` before saving,
+                so that identical fonts, images and other page resources are
+                written once. This modifies the ``Pdf``.
+
             normalize_content: Enables parsing and reformatting the
                 content stream within PDFs. This may debugging PDFs easier.
 
@@ -716,7 +1060,7 @@ class Extend_Pdf:
         to generate different versions of a file, and you *may* continue
         to modify the file after saving it. ``.save()`` does not modify
         the ``Pdf`` object in memory, except possibly by updating the XMP
-        metadata version with ``fix_metadata_version``.
+        metadata version with ``fix_metadata_version``, and with *deduplicate*.
 
         .. note::
 
@@ -725,6 +1069,15 @@ class Extend_Pdf:
             are any objects (such as images) that are referenced in a page's
             Resources dictionary but never called in the page's content stream.
 
+        .. note::
+
+            Threading: ``.save()`` holds the GIL until it returns, so other
+            threads may use this ``Pdf`` before and after a save, but do not run
+            during it. Saves of different ``Pdf`` objects do not run in
+            parallel; use *workers* to compress a single save's streams on
+            several threads. If another thread saves or closes the same ``Pdf``
+            while a save calls into Python, it waits for the save to finish.
+
         .. note::
 
             pikepdf can read PDFs with incremental updates, but always
@@ -736,7 +1089,7 @@ class Extend_Pdf:
 
         .. versionchanged:: 3.0
             Keyword arguments now mandatory for everything except the first
-            argument.
+            argument. Added *workers*, *incremental* and *deduplicate*.
         """
         if not filename_or_stream and getattr(self, '_original_filename', None):
             filename_or_stream = self._original_filename
@@ -749,6 +1102,16 @@ class Extend_Pdf:
                 "Pdf.new(), you must specify a destination object since there is "
                 "no original filename to save to."
             )
+        if incremental:
+            if linearize or qdf or normalize_content or workers:
+                raise ValueError(
+                    "incremental saves cannot be combined with linearize, qdf, "
+                    "normalize_content or workers"
+                )
+            if encryption:
+                raise ValueError("incremental saves cannot be combined with encryption")
+            self._save_incremental(filename_or_stream, deduplicate=deduplicate)
+            return
         self._save(
             filename_or_stream,
             static_id=static_id,
@@ -766,8 +1129,33 @@ class Extend_Pdf:
             encryption=encryption,
             samefile_check=getattr(self, '_tmp_stream', None) is None,
             recompress_flate=recompress_flate,
+            workers=workers,
+            deduplicate=deduplicate,
         )
 
+    def _save_incremental(self, filename_or_stream, *, deduplicate=False):
+        source = getattr(self, '_original_filename', None)
+        if not source and self._has_source_file:
+            source = Path(self.filename)
+        if not source:
+            raise ValueError(
+                "incremental saves require a Pdf that was opened from a file"
+            )
+        update = self._incremental_update(os.fspath(source), deduplicate=deduplicate)
+
+        if hasattr(filename_or_stream, 'write'):
+            with open(source, 'rb') as original:
+                shutil.copyfileobj(original, filename_or_stream)
+            filename_or_stream.write(update)
+            return
+
+        target = Path(filename_or_stream)
+        if not (target.exists() and target.samefile(source)):
+            shutil.copyfile(source, target)
+        if update:
+            with open(target, 'ab') as output:
+                output.write(update)
+
     @staticmethod
     def open(
         filename_or_stream: Union[Path, str, BinaryIO],
@@ -844,10 +1232,11 @@ class Extend_Pdf:
                 selected stream access. To attempt memory mapping and fallback
                 to stream if memory mapping failed, use ``.mmap``.  Use
                 ``.mmap_only`` to require memory mapping or fail
-                (this is expected to only be useful for testing). Applications
-                should be prepared to handle the SIGBUS signal on POSIX in
-                the event that the file is successfully mapped but later goes
-                away.
+                (this is expected to only be useful for testing). On POSIX
+                platforms, files opened by path are mapped natively, without the
+                GIL. Applications should be prepared to handle the SIGBUS signal
+                on POSIX in the event that the file is successfully mapped but
+                later goes away.
             allow_overwriting_input: If True, allows calling ``.save()``
                 to overwrite the input file. This is performed by loading the
                 entire input file into memory at open time; this will use more
@@ -873,7 +1262,7 @@ class Extend_Pdf:
 
         .. versionchanged:: 3.0
             Keyword arguments now mandatory for everything except the first
-            argument.
+            argument. Added *workers* and *incremental*.
         """
         if isinstance(filename_or_stream, bytes) and filename_or_stream.startswith(
             b'%PDF-'
@@ -1241,7 +1630,9 @@ class Extend_Attachments(MutableMapping):
 @augments(AttachedFileSpec)
 class Extend_AttachedFileSpec:
     @staticmethod
-    def from_filepath(pdf: Pdf, path: Union[Path, str], *, description: str = ''):
+    def from_filepath(
+        pdf: Pdf, path: Union[Path, str], *, description: str = '', lazy: bool = False
+    ):
         """Construct a file specification from a file path.
 
         This function will automatically add a creation and modified date
@@ -1252,6 +1643,13 @@ class Extend_AttachedFileSpec:
             path: A file path for the file to attach to this Pdf.
             description: An optional description. May be shown to the user in
                 PDF viewers.
+            lazy: If ``True``, the file's contents are read when they are needed,
+                usually when the Pdf is saved, rather than loaded into memory now;
+                see :meth:`pikepdf.Object.write_from`. The file must then still
+                exist, unchanged, when the Pdf is saved.
+
+        .. versionchanged:: 3.0
+            Added *lazy*.
         """
         mime, _ = mimetypes.guess_type(str(path))
         if mime is None:
@@ -1260,9 +1658,14 @@ class Extend_AttachedFileSpec:
             path = Path(path)
 
         stat = path.stat()
+        if lazy:
+            data = Stream(pdf, b'')
+            data.write_from(path)
+        else:
+            data = path.read_bytes()
         return AttachedFileSpec(
             pdf,
-            path.read_bytes(),
+            data,
             description=description,
             filename=str(path),
             mime_type=mime,
@@ -1307,6 +1710,17 @@ class Extend_AttachedFile:
     def read_bytes(self) -> bytes:
         return self.obj.read_bytes()
 
+    def open_reader(
+        self, *, chunk_size: int = 64 * 1024, spool_size: int = 4 * 1024 * 1024
+    ) -> StreamReader:
+        """Open the attached file's data as a read-only binary file.
+
+        See :meth:`pikepdf.Object.open_reader`.
+
+        .. versionadded:: 3.0
+        """
+        return self.obj.open_reader(chunk_size=chunk_size, spool_size=spool_size)
+
     def __repr__(self):
         return (
             f'<pikepdf._qpdf.AttachedFile objid={self.obj.objgen} size={self.size} '
@@ -0,0 +1,98 @@
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+
+"""Describe a PDF without opening it fully."""
+
+import os
+from pathlib import Path
+from typing import Dict, NamedTuple, Optional, Union
+
+from ._qpdf import _probe
+
+
+class ProbeResult(NamedTuple):
+    """What :func:`pikepdf.probe` found out about a file.
+
+    If the file is encrypted and the password was not correct, only
+    ``is_encrypted`` and ``password_correct`` are known, and the other fields are
+    ``None``.
+    """
+
+    path: Union[Path, str]
+    """The path, as it was given to :func:`pikepdf.probe`."""
+
+    is_encrypted: bool
+    """True if the file is encrypted."""
+
+    password_correct: bool
+    """False if the file is encrypted and the password did not open it."""
+
+    pdf_version: Optional[str] = None
+    """The PDF version, such as ``'1.7'``, from the file header, as in
+    :attr:`Pdf.pdf_version`. A ``/Version`` entry in the catalog that overrides
+    the header is not applied."""
+
+    extension_level: Optional[int] = None
+    """The Adobe extension level, or 0."""
+
+    is_linearized: Optional[bool] = None
+    """True if the file is linearized ("fast web view")."""
+
+    page_count: Optional[int] = None
+    """The number of pages recorded in the root of the page tree, or ``None`` if
+    the root has no valid ``/Count``. Unlike ``len(pdf.pages)``, the page tree is
+    not walked, so the count is not checked."""
+
+    docinfo: Optional[Dict[str, str]] = None
+    """The document information dictionary, with keys such as ``'/Title'``.
+    Strings are decoded to ``str``; other values are in PDF syntax."""
+
+    xmp: Optional[bytes] = None
+    """The XMP metadata stream, decoded, or ``None`` if there is none."""
+
+
+def probe(
+    path: Union[Path, str],
+    *,
+    password: Union[str, bytes] = "",
+    hex_password: bool = False,
+    attempt_recovery: bool = True,
+) -> ProbeResult:
+    """
+    Quickly describe a PDF file without opening it as a :class:`pikepdf.Pdf`.
+
+    Only the header, trailer and cross-reference table are parsed, and then the
+    document catalog, the root of the page tree, the document information
+    dictionary and the XMP metadata stream are read. No other objects are
+    read, so the time and memory used depend on the number of objects in the
+    file rather than its size. The GIL is released while the file is read.
+
+    Damaged files whose cross-reference table must be reconstructed are read in
+    full, as :meth:`pikepdf.Pdf.open` would, unless *attempt_recovery* is False.
+
+    Examples:
+
+        >>> info = pikepdf.probe('large.pdf')
+        >>> info.page_count, info.pdf_version, info.is_encrypted
+        (1200, '1.7', False)
+
+    Args:
+        path: Filename of the PDF. Streams are not supported.
+        password: Password for an encrypted file. See :meth:`pikepdf.Pdf.open`.
+        hex_password: See :meth:`pikepdf.Pdf.open`.
+        attempt_recovery: See :meth:`pikepdf.Pdf.open`.
+
+    .. versionadded:: 3.0
+    """
+    if isinstance(password, str):
+        password = password.encode('utf-8')
+    result = _probe(
+        os.fsencode(path),
+        password,
+        hex_password=hex_password,
+        attempt_recovery=attempt_recovery,
+    )
+    return ProbeResult(path=path, **result)
@@ -38,7 +38,7 @@ from pikepdf.models.encryption import Encryption, EncryptionInfo, Permissions
 from pikepdf.models.image import PdfInlineImage
 from pikepdf.models.metadata import PdfMetadata
 from pikepdf.models.outlines import Outline
-from pikepdf.objects import Array, Dictionary, Name, Stream
+from pikepdf.objects import Array, Dictionary, Name, Operator, Stream
 
 # This is the whole point of stub files, but apparently we have to do this...
 # pylint: disable=no-method-argument,unused-argument,no-self-use,too-many-public-methods
@@ -46,7 +46,8 @@ from pikepdf.objects import Array, Dictionary, Name, Stream
 T = TypeVar('T', bound='Object')
 Numeric = TypeVar('Numeric', int, float, Decimal)
 
-class Buffer: ...
+class Buffer:
+    def __len__(self) -> int: ...
 
 # Exceptions
 
@@ -120,11 +121,15 @@ class Object:
     def _ipython_key_completions_(self) -> Optional[KeysView]: ...
     def _inline_image_raw_bytes(self) -> bytes: ...
     def _parse_page_contents(self, callbacks: Callable) -> None: ...
-    def _parse_page_contents_grouped(
-        self, whitelist: str
-    ) -> List[Tuple[Collection[Union[Object, PdfInlineImage]], 'Operator']]: ...
+    def _parse_page_contents_grouped(self, whitelist: str) -> _ParsedContentStream: ...
     def _parse_stream(self, *args, **kwargs) -> Any: ...
-    def _parse_stream_grouped(self, *args, **kwargs) -> Any: ...
+    @staticmethod
+    def _parse_stream_grouped(
+        stream: Object, whitelist: str
+    ) -> _ParsedContentStream: ...
+    def _pipe_stream_data(
+        self, stream: BinaryIO, decode_level: StreamDecodeLevel = ...
+    ) -> None: ...
     def _repr_mimebundle_(self, include=None, exclude=None) -> Optional[Dict]: ...
     def _write(
         self,
@@ -132,9 +137,16 @@ class Object:
         filter: Object,  # pylint: disable=redefined-builtin
         decode_parms: Object,
     ) -> None: ...
+    def _write_from_provider(
+        self,
+        factory: Callable[[], Iterable[bytes]],
+        filter: Object,  # pylint: disable=redefined-builtin
+        decode_parms: Object,
+    ) -> None: ...
     def append(self, pyitem: Any) -> None: ...
     def as_dict(self) -> '_ObjectMapping': ...
     def as_list(self) -> '_ObjectList': ...
+    def content_digest(self, *, decode: bool = ..., cache: bool = ...) -> bytes: ...
     def emplace(self, other: Object, retain: Iterable['Name'] = ...) -> None: ...
     def extend(self, arg0: Iterable[Object]) -> None: ...
     @overload
@@ -150,6 +162,13 @@ class Object:
     def is_owned_by(self, possible_owner: 'Pdf') -> bool: ...
     def items(self) -> Iterable[Tuple[str, Object]]: ...
     def keys(self) -> Set[str]: ...
+    def open_reader(
+        self,
+        *,
+        chunk_size: int = ...,
+        decode_level: StreamDecodeLevel = ...,
+        spool_size: int = ...,
+    ) -> BinaryIO: ...
     @staticmethod
     def parse(stream: bytes, description: str = ...) -> Object: ...
     def read_bytes(self, decode_level: StreamDecodeLevel = ...) -> bytes: ...
@@ -167,6 +186,16 @@ class Object:
         decode_parms: Union['Dictionary', 'Array', None] = ...,
         type_check: bool = ...,
     ) -> None: ...
+    def write_from(
+        self,
+        source: Union[
+            Path, str, BinaryIO, Callable[[], Iterable[bytes]], Iterable[bytes]
+        ],
+        *,
+        filter: Union['Name', 'Array', None] = ...,  # pylint: disable=redefined-builtin
+        decode_parms: Union['Dictionary', 'Array', None] = ...,
+        type_check: bool = ...,
+    ) -> None: ...
     def __bytes__(self) -> bytes: ...
     @overload
     def __contains__(self, arg0: Object) -> bool: ...
@@ -224,6 +253,40 @@ class Object:
     @stream_dict.setter
     def stream_dict(self, val: Object) -> None: ...
 
+class _BatchOpener:
+    def __init__(
+        self,
+        paths: List[bytes],
+        workers: int,
+        password: Union[str, bytes] = ...,
+        hex_password: bool = ...,
+        ignore_xref_streams: bool = ...,
+        suppress_warnings: bool = ...,
+        attempt_recovery: bool = ...,
+        inherit_page_attributes: bool = ...,
+        decode_streams: bool = ...,
+    ) -> None: ...
+    def __iter__(self) -> _BatchOpener: ...
+    def __next__(self) -> Tuple[int, Optional[Pdf]]: ...
+    def _rethrow(self, index: int) -> None: ...
+    def close(self) -> None: ...
+
+class _ObjectTable:
+    def _find(
+        self, type: str, subtype: str, keys: List[str], filter: str
+    ) -> List[Object]: ...
+    def of_type(self, type: ObjectType) -> List[Object]: ...
+    @overload
+    def __getitem__(self, index: int) -> Object: ...
+    @overload
+    def __getitem__(self, index: slice) -> List[Object]: ...
+    def __iter__(self) -> _ObjectTableIterator: ...
+    def __len__(self) -> int: ...
+
+class _ObjectTableIterator:
+    def __iter__(self) -> _ObjectTableIterator: ...
+    def __next__(self) -> Object: ...
+
 class _ObjectList:
     @overload
     def __init__(self) -> None: ...
@@ -287,6 +350,12 @@ class _ObjectMapping:
     def __len__(self) -> int: ...
     def __setitem__(self, arg0: str, arg1: Object) -> None: ...
 
+class _ParsedContentStream:
+    def __getitem__(
+        self, index: int
+    ) -> Tuple[Collection[Union[Object, PdfInlineImage]], 'Operator']: ...
+    def __len__(self) -> int: ...
+
 class Operator(Object): ...
 
 class Annotation:
@@ -323,6 +392,7 @@ class AttachedFile:
     def md5(self) -> bytes: ...
     @property
     def obj(self) -> Object: ...
+    def open_reader(self, *, chunk_size: int = ..., spool_size: int = ...) -> BinaryIO: ...
     def read_bytes(self) -> bytes: ...
     @property
     def size(self) -> int: ...
@@ -332,7 +402,7 @@ class AttachedFileSpec:
     filename: str
     def __init__(
         self,
-        data: bytes,
+        data: Union[bytes, Object],
         *,
         description: str,
         filename: str,
@@ -349,7 +419,11 @@ class AttachedFileSpec:
     def obj(self) -> Object: ...
     @staticmethod
     def from_filepath(
-        pdf: 'Pdf', path: Union[Path, str], *, description: str = ''
+        pdf: 'Pdf',
+        path: Union[Path, str],
+        *,
+        description: str = '',
+        lazy: bool = False,
     ) -> 'AttachedFileSpec': ...
 
 class Attachments(MutableMapping[str, AttachedFileSpec]):
@@ -386,6 +460,16 @@ class TokenFilter(_QPDFTokenFilter):
     def __init__(self) -> None: ...
     def handle_token(self, token: Token = ...) -> Union[None, List, Token]: ...
 
+class ContentRules(_QPDFTokenFilter):
+    def __init__(
+        self,
+        *,
+        drop_operators: Iterable[Union[str, Operator]] = ...,
+        rename_resources: Dict[Union[str, Name], Union[str, Name]] = ...,
+        replace_colors: Dict[Tuple[float, ...], Tuple[float, ...]] = ...,
+        strip_text: bool = ...,
+    ) -> None: ...
+
 class StreamParser:
     def __init__(self) -> None: ...
     @abstractmethod
@@ -409,7 +493,7 @@ class Page:
     def _get_cropbox(self, arg0: bool) -> Object: ...
     def _get_mediabox(self, arg0: bool) -> Object: ...
     def _get_trimbox(self, arg0: bool) -> Object: ...
-    def add_content_token_filter(self, tf: TokenFilter) -> None: ...
+    def add_content_token_filter(self, tf: _QPDFTokenFilter) -> None: ...
     def add_overlay(self, other: Union[Object, Page], rect: Optional['Rectangle']): ...
     def add_underlay(self, other: Union[Object, Page], rect: Optional['Rectangle']): ...
     def as_form_xobject(self, handle_transformations: bool = ...) -> Object: ...
@@ -432,7 +516,7 @@ class Page:
     def get(
         self, key: Union[str, Name], default: Optional[T] = ...
     ) -> Union[Optional[T], Object]: ...
-    def get_filtered_contents(self, tf: TokenFilter) -> bytes: ...
+    def get_filtered_contents(self, tf: _QPDFTokenFilter) -> bytes: ...
     def index(self) -> int: ...
     def label(self) -> str: ...
     def parse_contents(self, arg0: StreamParser) -> None: ...
@@ -474,6 +558,12 @@ class PageList:
     @overload
     def extend(self, iterable: Iterable[Page]) -> None: ...
     def insert(self, index: int, obj: Page) -> None: ...
+    def map_native(
+        self,
+        op: Union[str, ContentRules, Iterable[Union[str, ContentRules]]],
+        *,
+        workers: Optional[int] = ...,
+    ) -> None: ...
     def p(self, pnum: int) -> Page: ...
     def remove(self, **kwargs) -> None: ...
     def reverse(self) -> None: ...
@@ -502,25 +592,59 @@ class Pdf:
     def _add_page(self, page: Object, first: bool = ...) -> None: ...
     def _add_page_at(self, arg0: Object, arg1: bool, arg2: Object) -> None: ...
     def _decode_all_streams_and_discard(self) -> None: ...
+    def _decode_streams_parallel(
+        self, workers: int
+    ) -> List[Tuple[Tuple[int, int], str]]: ...
     def _get_object_id(self, arg0: int, arg1: int) -> Object: ...
+    def _incremental_update(self, path: str, *, deduplicate: bool = False) -> bytes: ...
+    def _merge(
+        self,
+        sources: List[Union[Pdf, bytes]],
+        workers: int,
+        password: bytes = ...,
+        hex_password: bool = ...,
+        attempt_recovery: bool = ...,
+    ) -> int: ...
     def _process(self, arg0: str, arg1: bytes) -> None: ...
     def _remove_page(self, arg0: Object) -> None: ...
     def _replace_object(self, arg0: Tuple[int, int], arg1: Object) -> None: ...
     def _swap_objects(self, arg0: Tuple[int, int], arg1: Tuple[int, int]) -> None: ...
-    def check(self) -> List[str]: ...
+    def check(self, *, workers: int = ...) -> List[str]: ...
     def check_linearization(self, stream: object = ...) -> bool: ...
+    def checkpoint(self) -> None: ...
+    def clear_digest_cache(self) -> None: ...
+    def deduplicate(self) -> int: ...
     def close(self) -> None: ...
     def copy_foreign(self, h: Object) -> Object: ...
+    def get_changes(self) -> Dict[str, Union[List[Tuple[int, int]], bool]]: ...
     @overload
     def get_object(self, objgen: Tuple[int, int]) -> Object: ...
     @overload
     def get_object(self, objid: int, gen: int) -> Object: ...
     def get_warnings(self) -> list: ...
+    def is_changed(self, objgen: Tuple[int, int]) -> bool: ...
     @overload
     def make_indirect(self, h: T) -> T: ...
     @overload
     def make_indirect(self, obj: Any) -> Object: ...
+    def find_objects(
+        self,
+        *,
+        type: Union[Name, str, None] = ...,
+        subtype: Union[Name, str, None] = ...,
+        has_key: Union[Name, str, Iterable[Union[Name, str]], None] = ...,
+        filter: Union[Name, str, None] = ...,
+    ) -> List[Object]: ...
     def make_stream(self, data: bytes, d=None, **kwargs) -> Stream: ...
+    def merge(
+        self,
+        sources: Iterable[Union[Pdf, Path, str]],
+        *,
+        workers: Optional[int] = ...,
+        password: Union[str, bytes] = ...,
+        hex_password: bool = ...,
+        attempt_recovery: bool = ...,
+    ) -> int: ...
     @classmethod
     def new(cls) -> 'Pdf': ...
     @staticmethod
@@ -562,6 +686,9 @@ class Pdf:
         progress: Callable[[int], None] = None,
         encryption: Optional[Union[Encryption, bool]] = None,
         recompress_flate: bool = False,
+        workers: Optional[int] = None,
+        incremental: bool = False,
+        deduplicate: bool = False,
     ) -> None: ...
     def show_xref_table(self) -> None: ...
     @property
@@ -587,8 +714,12 @@ class Pdf:
     @property
     def _encryption_data(self) -> dict: ...
     @property
+    def _has_source_file(self) -> bool: ...
+    @property
     def _pages(self) -> Any: ...
     @property
+    def _read_cache_info(self) -> Optional[dict]: ...
+    @property
     def allow(self) -> Permissions: ...
     @property
     def docinfo(self) -> Object: ...
@@ -605,7 +736,7 @@ class Pdf:
     @property
     def is_linearized(self) -> bool: ...
     @property
-    def objects(self) -> Any: ...
+    def objects(self) -> _ObjectTable: ...
     @property
     def pages(self) -> PageList: ...
     @property
@@ -680,13 +811,27 @@ def _new_real(*args, **kwargs) -> Any: ...
 def _new_stream(arg0: Pdf, arg1: bytes) -> Object: ...
 def _new_string(s: Union[str, bytes]) -> Object: ...
 def _new_string_utf8(s: str) -> Object: ...
+def _probe(
+    path: bytes,
+    password: bytes = ...,
+    hex_password: bool = ...,
+    attempt_recovery: bool = ...,
+) -> Dict[str, Any]: ...
 def _test_file_not_found(*args, **kwargs) -> Any: ...
 def _translate_qpdf(arg0: str) -> str: ...
 def get_decimal_precision() -> int: ...
+def get_mmap_populate() -> bool: ...
+def get_read_cache_size() -> Tuple[int, int]: ...
+def get_save_buffer_size() -> int: ...
 def pdf_doc_to_utf8(pdfdoc: bytes) -> str: ...
 def qpdf_version() -> str: ...
 def set_access_default_mmap(mmap: bool) -> bool: ...
 def set_decimal_precision(prec: int) -> int: ...
+def set_mmap_populate(populate: bool) -> None: ...
+def set_read_cache_size(block_size: int, block_count: int) -> None: ...
+def set_save_buffer_size(size: int) -> None: ...
 def unparse(obj: Any) -> bytes: ...
 def utf8_to_pdf_doc(utf8: str, unknown: bytes) -> Tuple[bool, bytes]: ...
-def _unparse_content_stream(contentstream: Iterable[Any]) -> bytes: ...
+def _unparse_content_stream(
+    contentstream: Iterable[Any], parsed: Optional[_ParsedContentStream] = ...
+) -> bytes: ...
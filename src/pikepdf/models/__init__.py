@@ -4,7 +4,8 @@
 #
 # Copyright (C) 2017, James R. Barlow (https://github.com/jbarlow83/)
 
-from typing import Collection, List, Tuple, Union, cast
+from collections.abc import MutableSequence
+from typing import Collection, Iterator, List, Tuple, Union
 
 from pikepdf import Object, ObjectType, Operator, Page, PdfError, _qpdf
 
@@ -25,6 +26,91 @@ ContentStreamOperands = Collection[Union[Object, PdfInlineImage]]
 ContentStreamInstructions = Tuple[ContentStreamOperands, Operator]
 
 
+class ParsedContentStream(MutableSequence):
+    """
+    The instructions of a parsed content stream, as returned by
+    :func:`parse_content_stream`.
+
+    This behaves like a list of ``(operands, operator)`` tuples, but the
+    instructions are kept in a compact native form until they are accessed, so
+    parsing a large content stream does not create Python objects for instructions
+    that are never used. Each instruction is created once, on first access; after
+    that the same tuple is returned every time, so changes to its operands are
+    kept.
+
+    Inserting or deleting instructions creates all remaining instructions first.
+    Appending does not.
+
+    .. versionadded:: 3.0
+    """
+
+    __slots__ = ('_parsed', '_items')
+
+    def __init__(self, parsed):
+        self._parsed = parsed  # None once every instruction has been created
+        self._items = [None] * len(parsed)
+
+    def _load(self, index: int):
+        item = self._items[index]
+        if item is None and self._parsed is not None:
+            item = self._items[index] = self._parsed[index]
+        return item
+
+    def _load_all(self) -> None:
+        if self._parsed is None:
+            return
+        for index in range(len(self._parsed)):
+            self._load(index)
+        self._parsed = None
+
+    def __len__(self) -> int:
+        return len(self._items)
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self._load(i) for i in range(*index.indices(len(self._items)))]
+        if index < 0:
+            index += len(self._items)
+        if not 0 <= index < len(self._items):
+            raise IndexError("instruction index out of range")
+        return self._load(index)
+
+    def __iter__(self) -> Iterator[ContentStreamInstructions]:
+        for index in range(len(self._items)):
+            yield self._load(index)
+
+    def __setitem__(self, index, value) -> None:
+        if isinstance(index, slice):
+            self._load_all()
+        self._items[index] = value
+
+    def __delitem__(self, index) -> None:
+        self._load_all()
+        del self._items[index]
+
+    def insert(self, index: int, value) -> None:
+        self._load_all()
+        self._items.insert(index, value)
+
+    def append(self, value) -> None:
+        # Instructions still to be created keep their indexes
+        self._items.append(value)
+
+    def __eq__(self, other) -> bool:
+        if not isinstance(other, (list, tuple, ParsedContentStream)):
+            return NotImplemented
+        return len(self) == len(other) and all(a == b for a, b in zip(self, other))
+
+    def __add__(self, other) -> List[ContentStreamInstructions]:
+        return list(self) + list(other)
+
+    def __radd__(self, other) -> List[ContentStreamInstructions]:
+        return list(other) + list(self)
+
+    def __repr__(self) -> str:
+        return f"<pikepdf.models.ParsedContentStream, {len(self)} instructions>"
+
+
 class PdfParsingError(Exception):
     def __init__(self, message=None, line=None):
         if not message:
@@ -35,7 +121,7 @@ class PdfParsingError(Exception):
 
 def parse_content_stream(
     page_or_stream: Union[Object, Page], operators: str = ''
-) -> List[ContentStreamInstructions]:
+) -> ParsedContentStream:
     """
     Parse a PDF content stream into a sequence of instructions.
 
@@ -62,9 +148,11 @@ def parse_content_stream(
             all tokens are accepted.
 
     Returns:
-        List of ``(operands, command)`` tuples where ``command`` is an
-        operator (str) and ``operands`` is a tuple of str; the PDF drawing
-        command and the command's operands, respectively.
+        A list-like :class:`ParsedContentStream` of ``(operands, command)``
+        tuples where ``command`` is an operator (str) and ``operands`` is a
+        tuple of str; the PDF drawing command and the command's operands,
+        respectively. Operators not in *operators* are filtered out during
+        parsing, before any Python objects are created.
 
     Example:
 
@@ -91,23 +179,17 @@ def parse_content_stream(
     try:
         if page_or_stream.get('/Type') == '/Page':
             page = page_or_stream
-            instructions = cast(
-                List[ContentStreamInstructions],
-                page._parse_page_contents_grouped(operators),
-            )
+            parsed = page._parse_page_contents_grouped(operators)
         else:
             stream = page_or_stream
-            instructions = cast(
-                List[ContentStreamInstructions],
-                Object._parse_stream_grouped(stream, operators),
-            )
+            parsed = Object._parse_stream_grouped(stream, operators)
     except PdfError as e:
         if 'supposed to be a stream or an array' in str(e):
             raise TypeError("parse_content_stream called on non-stream Object") from e
         else:
             raise e from e
 
-    return instructions
+    return ParsedContentStream(parsed)
 
 
 def unparse_content_stream(
@@ -127,6 +209,12 @@ def unparse_content_stream(
     """
 
     try:
+        if isinstance(instructions, ParsedContentStream):
+            # Instructions that were never accessed are written straight from the
+            # native parse, without creating Python objects for them
+            return _qpdf._unparse_content_stream(
+                instructions._items, instructions._parsed
+            )
         return _qpdf._unparse_content_stream(instructions)
     except (ValueError, TypeError, RuntimeError) as e:
         raise PdfParsingError(
@@ -530,10 +530,10 @@ class PdfImage(PdfImageBase):
             raise HifiPrintImageNotTranscodableError()
 
         if self.mode == 'RGB' and self.bits_per_component == 8:
-            # No point in accessing the buffer here, size qpdf decodes to 3-byte
-            # RGB and Pillow needs RGBX for raw access
+            # Pillow needs RGBX for raw access, so it will copy 3-byte RGB anyway,
+            # but reading through the buffer avoids making a bytes copy first
             im = Image.frombuffer(
-                'RGB', self.size, self.read_bytes(), 'raw', 'RGB', 0, 1
+                'RGB', self.size, self.get_stream_buffer(), 'raw', 'RGB', 0, 1
             )
         elif self.mode == 'CMYK' and self.bits_per_component == 8:
             im = Image.frombuffer(
@@ -579,7 +579,7 @@ class PdfImage(PdfImageBase):
                 jbig2_globals_obj = self.filter_decodeparms[0][1].get('/JBIG2Globals')
                 im = jbig2.extract_jbig2(self.obj, jbig2_globals_obj)
             else:
-                data = self.read_bytes()
+                data = self.get_stream_buffer()
                 im = Image.frombytes('1', self.size, data)
         else:
             raise UnsupportedImageTypeError(repr(self) + ", " + repr(self.obj))
@@ -692,7 +692,10 @@ class PdfImage(PdfImageBase):
         return self.obj.read_bytes(decode_level=decode_level)
 
     def get_stream_buffer(self, decode_level=StreamDecodeLevel.specialized):
-        """Access this image with the buffer protocol"""
+        """Access this image with the buffer protocol, without copying it to bytes
+
+        The returned buffer is read-only.
+        """
         return self.obj.get_stream_buffer(decode_level=decode_level)
 
     def as_pil_image(self) -> Image.Image:
@@ -0,0 +1,845 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/Pl_Buffer.hh>
+#include <qpdf/Pl_Discard.hh>
+#include <qpdf/Pl_Flate.hh>
+#include <qpdf/Pipeline.hh>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "pikepdf.h"
+#include "qpdf_state.h"
+#include "gsl.h"
+
+std::shared_ptr<QPDF> open_source_file(const SourceFile &source, bool suppress_warnings)
+{
+    auto q = make_qpdf();
+    qpdf_basic_settings(*q);
+    q->setSuppressWarnings(suppress_warnings);
+    q->setPasswordIsHexKey(source.hex_password);
+    q->setIgnoreXRefStreams(source.ignore_xref_streams);
+    q->setAttemptRecovery(source.attempt_recovery);
+    q->processFile(source.path.c_str(), source.password.c_str());
+    if (!q->isEncrypted()) {
+        auto &stored = get_pdf_state(*q).source_file;
+        stored       = std::make_unique<SourceFile>(source);
+        stored->password.clear();
+    }
+    return q;
+}
+
+std::vector<StreamProblem> decode_streams_parallel(QPDF &q, size_t workers)
+{
+    auto *source = get_pdf_state(q).source_file.get();
+    if (!source)
+        throw py::value_error("Pdf was not opened from an unencrypted file, so it "
+                              "cannot be decoded in parallel");
+    if (workers == 0)
+        throw py::value_error("workers must be at least 1");
+
+    std::vector<QPDFObjGen> streams;
+    for (auto &obj : q.getAllObjects())
+        if (obj.isStream())
+            streams.push_back(obj.getObjGen());
+    workers = std::max<size_t>(1, std::min(workers, streams.size()));
+
+    const SourceFile source_copy = *source;
+    std::atomic<size_t> next_stream{0};
+    std::mutex problems_mutex;
+    std::vector<StreamProblem> problems;
+
+    auto add_problem = [&](QPDFObjGen og, const QPDFExc &e) {
+        std::lock_guard<std::mutex> lock(problems_mutex);
+        problems.push_back({og, e});
+    };
+
+    // Each worker decodes streams from its own QPDF, because a QPDF resolves and
+    // caches objects as they are read, so it cannot be shared between threads.
+    auto worker = [&](size_t) {
+        std::shared_ptr<QPDF> view;
+        try {
+            view = open_source_file(source_copy, true);
+        } catch (const QPDFExc &e) {
+            add_problem(QPDFObjGen(), e);
+            return;
+        } catch (const std::exception &e) {
+            add_problem(QPDFObjGen(),
+                QPDFExc(qpdf_e_system, source_copy.path, "", 0, e.what()));
+            return;
+        }
+
+        for (size_t index = next_stream++; index < streams.size();
+             index         = next_stream++) {
+            auto og = streams[index];
+            try {
+                auto stream = view->getObjectByObjGen(og);
+                if (!stream.isStream())
+                    continue;
+                Pl_Discard discard;
+                stream.pipeStreamData(&discard, 0, qpdf_dl_all);
+            } catch (const QPDFExc &e) {
+                add_problem(og, e);
+            } catch (const std::exception &e) {
+                add_problem(og,
+                    QPDFExc(qpdf_e_damaged_pdf,
+                        view->getFilename(),
+                        "object " + std::to_string(og.getObj()) + " " +
+                            std::to_string(og.getGen()),
+                        0,
+                        e.what()));
+            }
+            // Decoding errors are reported as warnings
+            for (auto &warning : view->getWarnings())
+                add_problem(og, warning);
+        }
+    };
+
+    {
+        py::gil_scoped_release release;
+        run_workers(workers, worker);
+    }
+
+    std::stable_sort(problems.begin(),
+        problems.end(),
+        [](const StreamProblem &a, const StreamProblem &b) { return a.og < b.og; });
+    for (auto &problem : problems)
+        q.warn(problem.error);
+    return problems;
+}
+
+// Decoded stream data is compressed in batches of about this many bytes, which
+// bounds the memory used for uncompressed data
+constexpr size_t precompress_batch_bytes = 64 * 1024 * 1024;
+
+// A Pl_Buffer that throws once it is asked to hold more than limit bytes
+class Pl_BoundedBuffer : public Pipeline {
+public:
+    Pl_BoundedBuffer(const char *identifier, size_t limit)
+        : Pipeline(identifier, nullptr), limit(limit), buffer(identifier)
+    {
+    }
+    void write(unsigned char *buf, size_t len) override
+    {
+        if (len > this->limit - this->size)
+            throw std::length_error("stream is too large to precompress");
+        this->size += len;
+        this->buffer.write(buf, len);
+    }
+    void finish() override { this->buffer.finish(); }
+    Buffer *getBuffer() { return this->buffer.getBuffer(); }
+
+private:
+    const size_t limit;
+    size_t size = 0;
+    Pl_Buffer buffer;
+};
+
+// Whether QPDFWriter, with compress_streams enabled, would Flate-compress this
+// stream while writing it
+static bool writer_would_compress(QPDFObjectHandle stream, bool recompress_flate)
+{
+    auto dict = stream.getDict();
+    auto type = dict.getKey("/Type");
+    if (type.isName() && type.getName() == "/Metadata")
+        return false; // QPDFWriter writes metadata uncompressed at any decode level
+    auto filter = dict.getKey("/Filter");
+    if (!recompress_flate && !stream.isDataModified() && filter.isName() &&
+        (filter.getName() == "/FlateDecode" || filter.getName() == "/Fl"))
+        return false; // Already compressed, and written as is
+    return true;
+}
+
+void precompress_streams(QPDF &q,
+    qpdf_stream_decode_level_e decode_level,
+    bool recompress_flate,
+    size_t workers,
+    std::vector<ReplacedStream> &replaced)
+{
+    if (workers == 0)
+        throw py::value_error("workers must be at least 1");
+
+    struct Job {
+        QPDFObjectHandle stream;
+        PointerHolder<Buffer> data;
+        PointerHolder<Buffer> compressed;
+        std::exception_ptr error;
+    };
+
+    // Streams that cannot be decoded at this level, such as images in formats
+    // qpdf does not decode, are left for QPDFWriter, which writes them as they
+    // are. Checking first means their data is never read here. So are streams
+    // larger than a batch, and modified streams whose data pikepdf did not set,
+    // such as streams copied from another PDF: there is no way to give those
+    // their data back afterwards without reading all of it into memory.
+    auto &sources = get_pdf_state(q).stream_data_sources;
+    std::vector<QPDFObjectHandle> streams;
+    for (auto &obj : q.getAllObjects()) {
+        if (!obj.isStream() || !writer_would_compress(obj, recompress_flate))
+            continue;
+        if (obj.isDataModified() && !sources.count(obj.getObjGen()))
+            continue;
+        auto length = obj.getDict().getKey("/Length");
+        if (!obj.isDataModified() && length.isInteger() &&
+            length.getUIntValue() > precompress_batch_bytes)
+            continue;
+        bool filterable = false;
+        try {
+            obj.pipeStreamData(nullptr, &filterable, 0, decode_level, true, true);
+        } catch (const std::exception &) {
+            continue;
+        }
+        if (filterable)
+            streams.push_back(obj);
+    }
+
+    auto next_unread = streams.begin();
+    while (next_unread != streams.end()) {
+        // Decode the next batch one stream at a time, because a QPDF cannot be
+        // used from several threads. With will_retry, a stream that fails to
+        // decode, or decodes to more than a batch, returns false instead of
+        // throwing, and is also left for QPDFWriter.
+        std::vector<Job> batch;
+        size_t batch_bytes = 0;
+        for (; next_unread != streams.end() && batch_bytes < precompress_batch_bytes;
+             ++next_unread) {
+            Pl_BoundedBuffer decoded("precompress", precompress_batch_bytes);
+            bool decoded_ok = false;
+            try {
+                decoded_ok =
+                    next_unread->pipeStreamData(&decoded, 0, decode_level, true, true);
+            } catch (const std::exception &) {
+            }
+            if (!decoded_ok)
+                continue;
+            PointerHolder<Buffer> data(decoded.getBuffer());
+            batch_bytes += data->getSize();
+            batch.push_back({*next_unread, data, {}, nullptr});
+        }
+
+        // Pl_Flate reads the level set by set_flate_compression_level() when it
+        // is constructed, and separate instances can be used on separate threads
+        std::atomic<size_t> next_job{0};
+        auto worker = [&](size_t) {
+            for (size_t index = next_job++; index < batch.size();
+                 index        = next_job++) {
+                auto &job = batch[index];
+                try {
+                    Pl_Buffer compressed("precompressed");
+                    Pl_Flate flate("precompress", &compressed, Pl_Flate::a_deflate);
+                    flate.write(job.data->getBuffer(), job.data->getSize());
+                    flate.finish();
+                    job.compressed = PointerHolder<Buffer>(compressed.getBuffer());
+                } catch (...) {
+                    job.error = std::current_exception();
+                }
+                job.data = PointerHolder<Buffer>();
+            }
+        };
+        run_workers(std::max<size_t>(1, std::min(workers, batch.size())), worker);
+
+        // Replace in object order, so the result does not depend on which worker
+        // compressed which stream
+        for (auto &job : batch) {
+            if (job.error)
+                std::rethrow_exception(job.error);
+            auto dict = job.stream.getDict();
+            ReplacedStream original{job.stream,
+                dict.getKey("/Filter"),
+                dict.getKey("/DecodeParms"),
+                dict.getKey("/Length"),
+                {},
+                {}};
+            if (job.stream.isDataModified()) {
+                // Buffers are copied; providers are kept, and not called
+                original.provider = sources.at(job.stream.getObjGen());
+                if (!original.provider.getPointer())
+                    original.raw_data = job.stream.getRawStreamData();
+            }
+            job.stream.replaceStreamData(job.compressed,
+                QPDFObjectHandle::newName("/FlateDecode"),
+                QPDFObjectHandle::newNull());
+            replaced.push_back(original);
+        }
+    }
+}
+
+void restore_streams(std::vector<ReplacedStream> &replaced)
+{
+    for (auto &original : replaced) {
+        if (original.provider.getPointer()) {
+            original.stream.replaceStreamData(
+                original.provider, original.filter, original.decode_parms);
+            continue;
+        }
+        if (original.raw_data.getPointer()) {
+            original.stream.replaceStreamData(
+                original.raw_data, original.filter, original.decode_parms);
+            continue;
+        }
+        // A stream read from the file keeps its offset in the file, and reads
+        // its data from there again once it has neither a buffer nor a
+        // provider, so it is no longer counted as modified
+        original.stream.replaceStreamData(
+            PointerHolder<QPDFObjectHandle::StreamDataProvider>(),
+            original.filter,
+            original.decode_parms);
+        if (!original.length.isNull())
+            original.stream.getDict().replaceKey("/Length", original.length);
+    }
+    replaced.clear();
+}
+
+// What pikepdf.probe() reports about a file. Gathered without the GIL.
+struct ProbeInfo {
+    bool password_correct = true;
+    bool encrypted        = false;
+    bool linearized       = false;
+    std::string version;
+    int extension_level = 0;
+    long long page_count = -1; // Unknown
+    std::vector<std::pair<std::string, std::string>> docinfo;
+    bool has_xmp = false;
+    std::string xmp;
+};
+
+// Read only what is needed to describe a file: processFile() parses the trailer
+// and cross-reference table, then the few objects below are resolved. The page
+// tree is not walked, and no other objects are read.
+static ProbeInfo probe_file(const SourceFile &source)
+{
+    ProbeInfo info;
+    QPDF q;
+    qpdf_basic_settings(q);
+    q.setSuppressWarnings(true);
+    q.setPasswordIsHexKey(source.hex_password);
+    q.setAttemptRecovery(source.attempt_recovery);
+    try {
+        q.processFile(source.path.c_str(), source.password.c_str());
+    } catch (const QPDFExc &e) {
+        if (e.getErrorCode() != qpdf_e_password)
+            throw;
+        info.password_correct = false;
+        info.encrypted        = true;
+        return info;
+    }
+
+    info.encrypted       = q.isEncrypted();
+    info.linearized      = q.isLinearized();
+    info.version         = q.getPDFVersion();
+    info.extension_level = q.getExtensionLevel();
+
+    auto root  = q.getRoot();
+    auto count = root.getKey("/Pages").getKey("/Count");
+    if (count.isInteger())
+        info.page_count = count.getIntValue();
+
+    auto docinfo = q.getTrailer().getKey("/Info");
+    if (docinfo.isDictionary()) {
+        for (auto &key : docinfo.getKeys()) {
+            auto value = docinfo.getKey(key);
+            info.docinfo.emplace_back(key,
+                value.isString() ? value.getUTF8Value() : value.unparseResolved());
+        }
+    }
+
+    auto metadata = root.getKey("/Metadata");
+    if (metadata.isStream()) {
+        try {
+            auto buf = metadata.getStreamData(qpdf_dl_generalized);
+            info.xmp.assign(
+                reinterpret_cast<const char *>(buf->getBuffer()), buf->getSize());
+            info.has_xmp = true;
+        } catch (const std::exception &) {
+            // Report undecodable metadata as missing
+        }
+    }
+    return info;
+}
+
+struct BatchOptions {
+    std::string password;
+    bool hex_password            = false;
+    bool ignore_xref_streams     = false;
+    bool suppress_warnings       = true;
+    bool attempt_recovery        = true;
+    bool inherit_page_attributes = true;
+    bool decode_streams          = false;
+};
+
+// Opens a list of files on a pool of native threads. The workers never call into
+// Python, so they run in parallel with each other and with the interpreter.
+// Results are handed back in the order they finish.
+class BatchOpener {
+public:
+    BatchOpener(std::vector<std::string> paths, size_t workers, BatchOptions options)
+        : paths(std::move(paths)), options(std::move(options))
+    {
+        if (workers == 0)
+            throw py::value_error("workers must be at least 1");
+        workers      = std::min(workers, this->paths.size());
+        this->window = 2 * workers;
+        try {
+            for (size_t n = 0; n < workers; ++n)
+                this->threads.emplace_back([this] { this->work(); });
+        } catch (...) {
+            this->close();
+            throw;
+        }
+    }
+    ~BatchOpener()
+    {
+        if (PyGILState_Check()) {
+            py::gil_scoped_release release;
+            this->close();
+        } else {
+            this->close();
+        }
+    }
+    BatchOpener(const BatchOpener &) = delete;
+    BatchOpener &operator=(const BatchOpener &) = delete;
+
+    // Return (index, Pdf) for the next file to finish, or (index, None) if it could
+    // not be opened; in that case rethrow(index) raises the reason.
+    py::tuple next()
+    {
+        if (this->delivered == this->paths.size() || this->stopping)
+            throw py::stop_iteration();
+
+        Result result;
+        bool ready = false;
+        while (!ready) {
+            {
+                py::gil_scoped_release release;
+                std::unique_lock<std::mutex> lock(this->mutex);
+                ready = this->finished.wait_for(lock,
+                    std::chrono::milliseconds(100),
+                    [this] { return !this->results.empty(); });
+                if (ready) {
+                    result = std::move(this->results.front());
+                    this->results.pop_front();
+                    --this->in_flight;
+                    this->room.notify_one();
+                }
+            }
+            if (!ready && PyErr_CheckSignals() != 0)
+                throw py::error_already_set();
+        }
+        ++this->delivered;
+
+        if (result.error) {
+            this->errors[result.index] = result.error;
+            return py::make_tuple(result.index, py::none());
+        }
+        return py::make_tuple(result.index, result.pdf);
+    }
+
+    void rethrow(size_t index)
+    {
+        auto found = this->errors.find(index);
+        if (found == this->errors.end())
+            throw py::key_error(std::to_string(index));
+        auto error = found->second;
+        this->errors.erase(found);
+        std::rethrow_exception(error);
+    }
+
+    // Stop handing out files and wait for the workers to finish the ones they have.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+            this->room.notify_all();
+        }
+        for (auto &thread : this->threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+private:
+    struct Result {
+        size_t index = 0;
+        std::shared_ptr<QPDF> pdf;
+        std::exception_ptr error;
+    };
+
+    void work()
+    {
+        while (!this->stopping) {
+            // Open at most window files ahead of the caller, as merge_sources()
+            // does, so that files are not opened faster than they are used
+            size_t index = 0;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->room.wait(lock, [this] {
+                    return this->stopping || this->in_flight < this->window;
+                });
+                if (this->stopping)
+                    break;
+                index = this->next_index++;
+                if (index >= this->paths.size())
+                    break;
+                ++this->in_flight;
+            }
+
+            Result result;
+            result.index = index;
+            try {
+                result.pdf = this->open(this->paths[index]);
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->results.push_back(std::move(result));
+            this->finished.notify_one();
+        }
+    }
+
+    std::shared_ptr<QPDF> open(const std::string &path)
+    {
+        SourceFile source;
+        source.path                = path;
+        source.password            = this->options.password;
+        source.hex_password        = this->options.hex_password;
+        source.ignore_xref_streams = this->options.ignore_xref_streams;
+        source.attempt_recovery    = this->options.attempt_recovery;
+
+        auto q = open_source_file(source, this->options.suppress_warnings);
+        if (this->options.inherit_page_attributes)
+            q->pushInheritedAttributesToPage();
+        if (this->options.decode_streams)
+            decode_all_streams_and_discard(*q);
+        return q;
+    }
+
+    const std::vector<std::string> paths;
+    const BatchOptions options;
+    size_t window = 0; // Set before the workers start
+    size_t next_index = 0; // Guarded by mutex
+    std::atomic<bool> stopping{false};
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::condition_variable room;
+    std::deque<Result> results; // Guarded by mutex
+    size_t in_flight = 0;       // Opening or not yet delivered; guarded by mutex
+
+    // Only used while holding the GIL
+    size_t delivered = 0;
+    std::map<size_t, std::exception_ptr> errors;
+};
+
+// Append every page in pages to the end of q's page tree, updating it once rather
+// than once per page
+static void append_pages(QPDF &q, const std::vector<QPDFObjectHandle> &pages)
+{
+    if (pages.empty())
+        return;
+
+    // addPage() flattens the page tree, so the rest can go straight into /Kids
+    q.addPage(pages.front(), false);
+    auto tree = q.getRoot().getKey("/Pages");
+    auto kids = tree.getKey("/Kids");
+    for (size_t n = 1; n < pages.size(); ++n) {
+        auto page = pages[n];
+        page.replaceKey("/Parent", tree);
+        kids.appendItem(page);
+    }
+    tree.replaceKey("/Count", QPDFObjectHandle::newInteger(kids.getArrayNItems()));
+    q.updateAllPagesCache();
+}
+
+// Sources given as paths that are no larger than this are copied into memory and
+// closed, instead of being kept open, one file descriptor each, for as long as q
+constexpr size_t merge_copy_bytes = 8 * 1024 * 1024;
+
+size_t merge_sources(QPDF &q,
+    const std::vector<MergeSource> &sources,
+    size_t workers,
+    const SourceFile &how_to_open)
+{
+    if (workers == 0)
+        throw py::value_error("workers must be at least 1");
+    for (auto &source : sources)
+        if (source.pdf.get() == &q)
+            throw py::value_error("cannot merge a Pdf into itself");
+
+    struct Slot {
+        std::shared_ptr<QPDF> pdf;
+        std::exception_ptr error;
+        bool ready = false;
+        bool small = false; // A file whose stream data is copied into q
+    };
+    std::vector<Slot> slots(sources.size());
+    std::vector<size_t> to_open;
+    for (size_t index = 0; index < sources.size(); ++index) {
+        if (sources[index].pdf) {
+            slots[index].pdf   = sources[index].pdf;
+            slots[index].ready = true;
+        } else {
+            to_open.push_back(index);
+        }
+    }
+
+    // Lock q and every open Pdf among the sources, so that none of them is saved
+    // or closed while pages are copied. They are locked in address order, so that
+    // merges in opposite directions on two threads cannot deadlock.
+    std::vector<QPDF *> to_lock{&q};
+    for (auto &source : sources)
+        if (source.pdf)
+            to_lock.push_back(source.pdf.get());
+    std::sort(to_lock.begin(), to_lock.end());
+    to_lock.erase(std::unique(to_lock.begin(), to_lock.end()), to_lock.end());
+    std::vector<std::unique_ptr<PdfSaveLock>> save_locks;
+    for (auto *pdf : to_lock)
+        save_locks.push_back(std::make_unique<PdfSaveLock>(*pdf));
+
+    auto &state = get_pdf_state(q);
+    std::vector<QPDFObjectHandle> copied;
+    std::vector<std::shared_ptr<QPDF>> opened;
+
+    // copyForeignObject() returns the same page again if it was copied from the
+    // same source before, by an earlier source or by pages.extend(). A page may
+    // appear only once in the page tree, so such pages are shallow copies, as
+    // QPDF::addPage() does.
+    std::unordered_set<QPDFObjGen, ObjGenHash> pages_in_q;
+    for (auto &page : q.getAllPages())
+        pages_in_q.insert(page.getObjGen());
+    auto copy_pages = [&](QPDF &source) {
+        for (auto &page : source.getAllPages()) {
+            auto copy = q.copyForeignObject(page);
+            if (!pages_in_q.insert(copy.getObjGen()).second) {
+                copy = q.makeIndirectObject(copy.shallowCopy());
+                pages_in_q.insert(copy.getObjGen());
+            }
+            copied.push_back(copy);
+        }
+    };
+    // Even if merging fails, objects already copied read their stream data from
+    // their source, so the sources must outlive q
+    auto keep_sources = gsl::finally([&] {
+        for (auto &source : opened)
+            note_copied_from(q, source.get());
+        state.merged_sources.insert(
+            state.merged_sources.end(), opened.begin(), opened.end());
+    });
+    {
+        // Reading q or a source that calls into Python needs the GIL
+        std::unique_ptr<py::gil_scoped_release> release;
+        if (!pdf_calls_python(q))
+            release = std::make_unique<py::gil_scoped_release>();
+
+        // Workers open files at most window sources ahead of the one being copied,
+        // so that only a few are open at once when merging many files
+        const size_t window = 2 * workers;
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t copying = 0;    // Guarded by mutex
+        bool stopping  = false; // Guarded by mutex
+        std::atomic<size_t> next_to_open{0};
+
+        auto work = [&] {
+            for (;;) {
+                size_t n = next_to_open++;
+                if (n >= to_open.size())
+                    return;
+                size_t index = to_open[n];
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(
+                        lock, [&] { return stopping || index < copying + window; });
+                    if (stopping)
+                        return;
+                }
+
+                Slot result;
+                try {
+                    SourceFile source = how_to_open;
+                    source.path       = sources[index].path;
+                    result.pdf        = open_source_file(source, true);
+                    result.pdf->pushInheritedAttributesToPage();
+                    std::ifstream file(source.path, std::ios::binary | std::ios::ate);
+                    result.small = file && file.tellg() >= 0 &&
+                                   static_cast<size_t>(file.tellg()) <= merge_copy_bytes;
+                } catch (...) {
+                    result.error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[index].pdf   = std::move(result.pdf);
+                slots[index].error = result.error;
+                slots[index].small = result.small;
+                slots[index].ready = true;
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        auto join_threads = gsl::finally([&] {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                changed.notify_all();
+            }
+            for (auto &thread : threads)
+                thread.join();
+        });
+        for (size_t n = 0; n < std::min(workers, to_open.size()); ++n)
+            threads.emplace_back(work);
+
+        // Copying must happen on this thread, in order. copyForeignObject() keeps
+        // one object map per source, so objects shared between pages of a source
+        // are copied once.
+        for (size_t index = 0; index < sources.size(); ++index) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return slots[index].ready; });
+                if (slots[index].error)
+                    std::rethrow_exception(slots[index].error);
+                opened.push_back(std::move(slots[index].pdf));
+            }
+            if (sources[index].pdf) {
+                // An open Pdf belongs to Python, and may read its objects through
+                // Python, so it is only read with the GIL held
+                py::gil_scoped_acquire gil;
+                opened.back()->pushInheritedAttributesToPage();
+                copy_pages(*opened.back());
+            } else if (slots[index].small) {
+                // Copy the stream data now, rather than reading it from the
+                // source when q is written, so the source can be closed
+                opened.back()->setImmediateCopyFrom(true);
+                copy_pages(*opened.back());
+                opened.pop_back();
+            } else {
+                copy_pages(*opened.back());
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                copying = index + 1;
+                changed.notify_all();
+            }
+        }
+
+        append_pages(q, copied);
+    }
+
+    state.page_index.invalidate();
+    journal_updated(q, copied);
+    journal_pages_changed(q);
+    return copied.size();
+}
+
+void init_batch(py::module_ &m)
+{
+    m.def(
+        "_probe",
+        [](std::string path,
+            std::string password,
+            bool hex_password,
+            bool attempt_recovery) {
+            SourceFile source;
+            source.path             = path;
+            source.password         = password;
+            source.hex_password     = hex_password;
+            source.attempt_recovery = attempt_recovery;
+
+            ProbeInfo info;
+            {
+                py::gil_scoped_release release;
+                info = probe_file(source);
+            }
+
+            py::dict result;
+            result["password_correct"] = info.password_correct;
+            result["is_encrypted"]     = info.encrypted;
+            if (!info.password_correct)
+                return result;
+            result["is_linearized"]   = info.linearized;
+            result["pdf_version"]     = info.version;
+            result["extension_level"] = info.extension_level;
+            result["page_count"] =
+                info.page_count >= 0 ? py::object(py::int_(info.page_count)) : py::none();
+            py::dict docinfo;
+            for (auto &item : info.docinfo) {
+                // Non-string values are unparsed, and may contain binary strings
+                auto value = py::reinterpret_steal<py::str>(PyUnicode_DecodeUTF8(
+                    item.second.data(), item.second.size(), "replace"));
+                if (!value)
+                    throw py::error_already_set();
+                docinfo[py::str(item.first)] = value;
+            }
+            result["docinfo"] = docinfo;
+            result["xmp"]     = info.has_xmp ? py::object(py::bytes(info.xmp)) : py::none();
+            return result;
+        },
+        py::arg("path"),
+        py::arg("password")         = "",
+        py::arg("hex_password")     = false,
+        py::arg("attempt_recovery") = true);
+
+    py::class_<BatchOpener>(m, "_BatchOpener")
+        .def(py::init([](std::vector<std::string> paths,
+                          size_t workers,
+                          std::string password,
+                          bool hex_password,
+                          bool ignore_xref_streams,
+                          bool suppress_warnings,
+                          bool attempt_recovery,
+                          bool inherit_page_attributes,
+                          bool decode_streams) {
+            BatchOptions options;
+            options.password                = password;
+            options.hex_password            = hex_password;
+            options.ignore_xref_streams     = ignore_xref_streams;
+            options.suppress_warnings       = suppress_warnings;
+            options.attempt_recovery        = attempt_recovery;
+            options.inherit_page_attributes = inherit_page_attributes;
+            options.decode_streams          = decode_streams;
+            return std::make_unique<BatchOpener>(
+                std::move(paths), workers, std::move(options));
+        }),
+            py::arg("paths"),
+            py::arg("workers"),
+            py::arg("password")                = "",
+            py::arg("hex_password")            = false,
+            py::arg("ignore_xref_streams")     = false,
+            py::arg("suppress_warnings")       = true,
+            py::arg("attempt_recovery")        = true,
+            py::arg("inherit_page_attributes") = true,
+            py::arg("decode_streams")          = false)
+        .def("__iter__", [](py::object self) { return self; })
+        .def("__next__", &BatchOpener::next)
+        .def("_rethrow", &BatchOpener::rethrow, py::arg("index"))
+        .def("close",
+            &BatchOpener::close,
+            "Stop opening files and wait for work in progress to finish.",
+            py::call_guard<py::gil_scoped_release>());
+}
@@ -20,6 +20,7 @@
 
 #include "pikepdf.h"
 #include "pipeline.h"
+#include "qpdf_state.h"
 
 void init_embeddedfiles(py::module_ &m)
 {
@@ -69,6 +70,48 @@ void init_embeddedfiles(py::module_ &m)
                 creation_date: PDF date string for when this file was creation.
                 mod_date: PDF date string for when this file was last modified.
             )~~~")
+        .def(py::init([](QPDF &q,
+                          QPDFObjectHandle stream,
+                          std::string description,
+                          std::string filename,
+                          std::string mime_type,
+                          std::string creation_date,
+                          std::string mod_date) {
+            if (!stream.isStream())
+                throw py::type_error("data must be bytes or a pikepdf.Stream");
+            if (stream.getOwningQPDF() != &q)
+                throw py::value_error("stream must belong to the same Pdf");
+            // Computes /Size and /CheckSum by reading the stream's data once
+            auto efstream = QPDFEFStreamObjectHelper::newFromStream(stream);
+            auto filespec =
+                QPDFFileSpecObjectHelper::createFileSpec(q, filename, efstream);
+
+            if (!description.empty())
+                filespec.setDescription(description);
+            if (!mime_type.empty())
+                efstream.setSubtype(mime_type);
+            if (!creation_date.empty())
+                efstream.setCreationDate(creation_date);
+            if (!mod_date.empty())
+                efstream.setModDate(mod_date);
+
+            return filespec;
+        }),
+            py::keep_alive<0, 1>(),
+            py::arg("q"),
+            py::arg("data"),
+            py::kw_only(),
+            py::arg("description")   = std::string(""),
+            py::arg("filename")      = std::string(""),
+            py::arg("mime_type")     = std::string(""),
+            py::arg("creation_date") = std::string(""),
+            py::arg("mod_date")      = std::string(""),
+            R"~~~(
+            Low-level constructor for attached file spec from an existing stream.
+
+            The stream's data is not copied; if it was set with
+            :meth:`pikepdf.Object.write_from`, it is read from its source on demand.
+            )~~~")
         .def_property_readonly("obj",
             [](QPDFFileSpecObjectHelper &spec) { return spec.getObjectHandle(); })
         .def_property("description",
@@ -167,8 +210,23 @@ void init_embeddedfiles(py::module_ &m)
         .def("_get_filespec",
             &QPDFEmbeddedFileDocumentHelper::getEmbeddedFile,
             py::return_value_policy::reference_internal)
-        .def("_add_replace_filespec",
-            &QPDFEmbeddedFileDocumentHelper::replaceEmbeddedFile,
+        .def(
+            "_add_replace_filespec",
+            [](QPDFEmbeddedFileDocumentHelper &efdh,
+                std::string const &name,
+                QPDFFileSpecObjectHelper &fs) {
+                efdh.replaceEmbeddedFile(name, fs);
+                if (auto *q = fs.getObjectHandle().getOwningQPDF())
+                    journal_incomplete(*q); // The name tree is changed by qpdf
+            },
             py::keep_alive<0, 2>())
-        .def("_remove_filespec", &QPDFEmbeddedFileDocumentHelper::removeEmbeddedFile);
+        .def("_remove_filespec",
+            [](QPDFEmbeddedFileDocumentHelper &efdh, std::string const &name) {
+                auto fs      = efdh.getEmbeddedFile(name);
+                bool removed = efdh.removeEmbeddedFile(name);
+                auto *q      = fs ? fs->getObjectHandle().getOwningQPDF() : nullptr;
+                if (removed && q)
+                    journal_incomplete(*q);
+                return removed;
+            });
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <cerrno>
 
 #include <qpdf/Constants.h>
 #include <qpdf/Types.h>
@@ -26,6 +27,17 @@
 
 #include "pikepdf.h"
 #include "utils.h"
+#include "gsl.h"
+
+#if !defined(_WIN32)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define PIKEPDF_NATIVE_MMAP 1
+#endif
+
+extern bool MMAP_POPULATE;
 
 // We could almost subclass BufferInputSource here, except that it expects Buffer
 // as an initialization parameter, we don't know what the buffer location is until
@@ -133,3 +145,105 @@ private:
     std::unique_ptr<py::buffer_info> buffer_info;
     std::unique_ptr<BufferInputSource> bis;
 };
+
+#ifdef PIKEPDF_NATIVE_MMAP
+// An InputSource that memory maps a file by path using the POSIX API directly.
+// Unlike MmapInputSource, it never calls into Python, so it may be constructed,
+// read and destroyed without the GIL. The file descriptor is closed as soon as
+// the mapping is established.
+//
+// The mapping is advised as sequential while qpdf parses the xref table; call
+// advise_random() once the file is open, since object access is random from
+// then on.
+class PosixMmapInputSource : public InputSource {
+public:
+    PosixMmapInputSource(const std::string &path, const std::string &description)
+        : InputSource()
+    {
+        int fd = -1;
+        do {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0)
+            QUtil::throw_system_error(description);
+        auto close_fd = gsl::finally([fd] { ::close(fd); });
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+            QUtil::throw_system_error(description);
+        if (!S_ISREG(st.st_mode)) {
+            errno = ENODEV;
+            QUtil::throw_system_error(description);
+        }
+        this->length = static_cast<size_t>(st.st_size);
+
+        int flags = MAP_PRIVATE;
+#    ifdef MAP_POPULATE
+        if (MMAP_POPULATE)
+            flags |= MAP_POPULATE;
+#    endif
+        // mmap() fails with EINVAL on an empty file, the same as Python's mmap,
+        // so callers fall back to stream access.
+        void *addr = ::mmap(nullptr, this->length, PROT_READ, flags, fd, 0);
+        if (addr == MAP_FAILED)
+            QUtil::throw_system_error(description);
+        this->data = addr;
+        this->advise(POSIX_MADV_SEQUENTIAL);
+
+        auto qpdf_buffer = std::make_unique<Buffer>(
+            static_cast<unsigned char *>(this->data), this->length);
+        this->bis = std::make_unique<BufferInputSource>(description,
+            qpdf_buffer.release(),
+            false // own_memory=false
+        );
+    }
+    virtual ~PosixMmapInputSource()
+    {
+        this->bis.reset();
+        if (this->data)
+            ::munmap(this->data, this->length);
+    }
+    PosixMmapInputSource(const PosixMmapInputSource &) = delete;
+    PosixMmapInputSource &operator=(const PosixMmapInputSource &) = delete;
+    PosixMmapInputSource(PosixMmapInputSource &&)                 = delete;
+    PosixMmapInputSource &operator=(PosixMmapInputSource &&) = delete;
+
+    void advise_random() { this->advise(POSIX_MADV_RANDOM); }
+
+    std::string const &getName() const override { return this->bis->getName(); }
+
+    qpdf_offset_t tell() override { return this->bis->tell(); }
+
+    void seek(qpdf_offset_t offset, int whence) override
+    {
+        this->bis->seek(offset, whence);
+    }
+
+    // LCOV_EXCL_START
+    void rewind() override { this->bis->rewind(); }
+    // LCOV_EXCL_STOP
+
+    size_t read(char *buffer, size_t length) override
+    {
+        return this->bis->read(buffer, length);
+    }
+
+    void unreadCh(char ch) override { this->bis->unreadCh(ch); }
+
+    qpdf_offset_t findAndSkipNextEOL() override
+    {
+        return this->bis->findAndSkipNextEOL();
+    }
+
+private:
+    void advise(int advice)
+    {
+        // Advice is only a hint; ignore failure.
+        (void)::posix_madvise(this->data, this->length, advice);
+    }
+
+    void *data    = nullptr;
+    size_t length = 0;
+    std::unique_ptr<BufferInputSource> bis;
+};
+#endif // PIKEPDF_NATIVE_MMAP
@@ -17,6 +17,7 @@
 #include <pybind11/stl.h>
 
 #include "pikepdf.h"
+#include "qpdf_state.h"
 
 class NameTreeHolder {
 public:
@@ -42,6 +43,7 @@ public:
     void insert(std::string const &key, QPDFObjectHandle value)
     {
         (void)this->ntoh.insert(key, value);
+        this->changed();
     }
 
     void remove(std::string const &key)
@@ -49,12 +51,20 @@ public:
         bool result = this->ntoh.remove(key);
         if (!result)
             throw py::key_error(key);
+        this->changed();
     }
 
     QPDFNameTreeObjectHelper::iterator begin() { return this->ntoh.begin(); }
     QPDFNameTreeObjectHelper::iterator end() { return this->ntoh.end(); }
 
 private:
+    // qpdf may rebalance the tree, changing nodes the journal does not follow
+    void changed()
+    {
+        if (auto *q = this->ntoh.getObjectHandle().getOwningQPDF())
+            journal_incomplete(*q);
+    }
+
     QPDFNameTreeObjectHelper ntoh;
 };
 
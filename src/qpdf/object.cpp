@@ -24,9 +24,11 @@
 #include <pybind11/stl.h>
 
 #include "pikepdf.h"
+#include "qpdf_state.h"
 #include "utils.h"
 
 #include "parsers.h"
+#include "pipeline.h"
 
 /*
 Type table
@@ -190,7 +192,9 @@ QPDFObjectHandle object_get_key(QPDFObjectHandle h, std::string const &key)
     QPDFObjectHandle dict = h.isStream() ? h.getDict() : h;
     if (!dict.hasKey(key))
         throw py::key_error(key);
-    return dict.getKey(key);
+    auto value = dict.getKey(key);
+    journal_watch(h, value);
+    return value;
 }
 
 void object_set_key(QPDFObjectHandle h, std::string const &key, QPDFObjectHandle &value)
@@ -213,6 +217,7 @@ void object_set_key(QPDFObjectHandle h, std::string const &key, QPDFObjectHandle
 
     // A stream dictionary has no owner, so use the stream object in this comparison
     dict.replaceKey(key, value);
+    journal_modified(h);
 }
 
 void object_del_key(QPDFObjectHandle h, std::string const &key)
@@ -230,6 +235,7 @@ void object_del_key(QPDFObjectHandle h, std::string const &key)
         throw py::key_error(key);
 
     dict.removeKey(key);
+    journal_modified(h);
 }
 
 std::pair<int, int> object_get_objgen(QPDFObjectHandle h)
@@ -258,6 +264,41 @@ PointerHolder<Buffer> get_stream_data(
     }
 }
 
+// Supplies stream data on demand from a Python callable that returns an iterable of
+// bytes-like chunks. qpdf may ask for the data more than once, for example to
+// compute an embedded file's checksum and then again when saving, so the callable
+// is called afresh each time.
+class PythonStreamDataProvider : public QPDFObjectHandle::StreamDataProvider {
+public:
+    PythonStreamDataProvider(py::object factory) : factory(factory) {}
+    virtual ~PythonStreamDataProvider()
+    {
+        // qpdf may drop the last reference to a provider without the GIL, for
+        // example while saving
+        py::gil_scoped_acquire gil;
+        this->factory = py::object();
+    }
+
+    void provideStreamData(int objid, int generation, Pipeline *pipeline) override
+    {
+        py::gil_scoped_acquire gil;
+        py::iterable chunks = this->factory();
+        for (auto chunk : chunks) {
+            py::buffer buffer = py::reinterpret_borrow<py::buffer>(chunk);
+            py::buffer_info info = buffer.request();
+            auto data = static_cast<unsigned char *>(info.ptr);
+            auto size = static_cast<size_t>(info.size * info.itemsize);
+            // info keeps the chunk's memory alive; compress without the GIL
+            py::gil_scoped_release release;
+            pipeline->write(data, size);
+        }
+        pipeline->finish();
+    }
+
+private:
+    py::object factory;
+};
+
 void init_object(py::module_ &m)
 {
     py::enum_<QPDFObject::object_type_e>(m, "ObjectType")
@@ -275,6 +316,8 @@ void init_object(py::module_ &m)
         .value("operator", QPDFObject::object_type_e::ot_operator)
         .value("inlineimage", QPDFObject::object_type_e::ot_inlineimage);
 
+    // The buffer is exported read-only: it may be shared with qpdf's own copy of
+    // the stream data, and callers expect read_bytes() semantics.
     py::class_<Buffer, PointerHolder<Buffer>>(m, "Buffer", py::buffer_protocol())
         .def_buffer([](Buffer &b) -> py::buffer_info {
             return py::buffer_info(b.getBuffer(),
@@ -282,8 +325,10 @@ void init_object(py::module_ &m)
                 py::format_descriptor<unsigned char>::format(),
                 1,
                 {b.getSize()},
-                {sizeof(unsigned char)});
-        });
+                {sizeof(unsigned char)},
+                true);
+        })
+        .def("__len__", &Buffer::getSize);
 
     py::bind_vector<ObjectList>(m, "_ObjectList") // Autoformat fix
         .def("__repr__", [](ObjectList &ol) {
@@ -304,6 +349,14 @@ void init_object(py::module_ &m)
 
     py::bind_map<ObjectMap>(m, "_ObjectMapping");
 
+    py::class_<ParsedContentStream, std::shared_ptr<ParsedContentStream>>(
+        m, "_ParsedContentStream")
+        .def("__len__", &ParsedContentStream::size)
+        .def("__getitem__",
+            &ParsedContentStream::instruction,
+            "Create the Python objects for one instruction, as (operands, operator).",
+            py::arg("index"));
+
     py::class_<QPDFObjectHandle>(m, "Object")
         .def_property_readonly("_type_code", &QPDFObjectHandle::getTypeCode)
         .def_property_readonly("_type_name", &QPDFObjectHandle::getTypeName)
@@ -373,6 +426,33 @@ void init_object(py::module_ &m)
                 }
                 throw std::logic_error("don't know how to hash this"); // LCOV_EXCL_LINE
             })
+        .def("content_digest",
+            &objecthandle_digest,
+            py::kw_only(),
+            py::arg("decode") = false,
+            py::arg("cache")  = false,
+            R"~~~(
+            Return a SHA-256 digest of this object's content, as bytes.
+
+            Objects that compare equal with ``==`` have the same digest, and so do
+            objects that have the same structure, even if they belong to different
+            Pdfs or their indirect objects have different object numbers. Indirect
+            objects are followed, so the digest covers everything the object refers
+            to; cycles of references are allowed. Unlike ``hash()``, which refuses
+            mutable objects, this works for arrays, dictionaries and streams, but
+            the digest changes whenever the object or anything it refers to changes.
+
+            Args:
+                decode: For streams, digest the decoded data instead of the data
+                    as stored, so that streams compressed differently have the same
+                    digest. Streams that cannot be decoded are digested as stored.
+                cache: Remember the digests of indirect objects in the Pdf and reuse
+                    them for later calls. The cache is not updated when objects are
+                    modified; use :meth:`pikepdf.Pdf.clear_digest_cache` after
+                    making changes.
+
+            .. versionadded:: 3.0
+            )~~~")
         .def(
             "__eq__",
             [](QPDFObjectHandle &self, QPDFObjectHandle &other) {
@@ -510,7 +590,10 @@ void init_object(py::module_ &m)
             "attribute lookup name")
         .def_property("stream_dict",
             &QPDFObjectHandle::getDict,
-            &QPDFObjectHandle::replaceDict,
+            [](QPDFObjectHandle &h, QPDFObjectHandle &dict) {
+                h.replaceDict(dict);
+                journal_modified(h);
+            },
             "Access the dictionary key-values for a :class:`pikepdf.Stream`.",
             py::return_value_policy::reference_internal)
         .def(
@@ -617,13 +700,27 @@ void init_object(py::module_ &m)
                 }
                 return false;
             })
-        .def("as_list", &QPDFObjectHandle::getArrayAsVector)
-        .def("as_dict", &QPDFObjectHandle::getDictAsMap)
+        .def("as_list",
+            [](QPDFObjectHandle &h) {
+                auto vec = h.getArrayAsVector();
+                for (auto &item : vec)
+                    journal_watch(h, item);
+                return vec;
+            })
+        .def("as_dict",
+            [](QPDFObjectHandle &h) {
+                auto dict = h.getDictAsMap();
+                for (auto &item : dict)
+                    journal_watch(h, item.second);
+                return dict;
+            })
         .def(
             "__iter__",
             [](QPDFObjectHandle h) -> py::iterable {
                 if (h.isArray()) {
-                    auto vec   = h.getArrayAsVector();
+                    auto vec = h.getArrayAsVector();
+                    for (auto &item : vec)
+                        journal_watch(h, item);
                     auto pyvec = py::cast(vec);
                     return pyvec.attr("__iter__")();
                 } else if (h.isDictionary() || h.isStream()) {
@@ -640,11 +737,12 @@ void init_object(py::module_ &m)
         .def(
             "items",
             [](QPDFObjectHandle h) -> py::iterable {
-                if (h.isStream())
-                    h = h.getDict();
-                if (!h.isDictionary())
+                auto d = h.isStream() ? h.getDict() : h;
+                if (!d.isDictionary())
                     throw py::type_error("items() not available on this type");
-                auto dict   = h.getDictAsMap();
+                auto dict = d.getDictAsMap();
+                for (auto &item : dict)
+                    journal_watch(h, item.second);
                 auto pydict = py::cast(dict);
                 return pydict.attr("items")();
             },
@@ -676,23 +774,28 @@ void init_object(py::module_ &m)
         .def("__getitem__",
             [](QPDFObjectHandle &h, int index) {
                 size_t u_index = list_range_check(h, index);
-                return h.getArrayItem(u_index);
+                auto item      = h.getArrayItem(u_index);
+                journal_watch(h, item);
+                return item;
             })
         .def("__setitem__",
             [](QPDFObjectHandle &h, int index, QPDFObjectHandle &value) {
                 size_t u_index = list_range_check(h, index);
                 h.setArrayItem(u_index, value);
+                journal_modified(h);
             })
         .def("__setitem__",
             [](QPDFObjectHandle &h, int index, py::object pyvalue) {
                 size_t u_index = list_range_check(h, index);
                 auto value     = objecthandle_encode(pyvalue);
                 h.setArrayItem(u_index, value);
+                journal_modified(h);
             })
         .def("__delitem__",
             [](QPDFObjectHandle &h, int index) {
                 size_t u_index = list_range_check(h, index);
                 h.eraseItem(u_index);
+                journal_modified(h);
             })
         .def(
             "wrap_in_array",
@@ -702,7 +805,8 @@ void init_object(py::module_ &m)
             "append",
             [](QPDFObjectHandle &h, py::object pyitem) {
                 auto item = objecthandle_encode(pyitem);
-                return h.appendItem(item);
+                h.appendItem(item);
+                journal_modified(h);
             },
             "Append another object to an array; fails if the object is not an array.")
         .def(
@@ -711,6 +815,7 @@ void init_object(py::module_ &m)
                 for (auto item : iter) {
                     h.appendItem(objecthandle_encode(item));
                 }
+                journal_modified(h);
             },
             "Extend a pikepdf.Array with an iterable of other objects.")
         .def_property_readonly("is_rectangle",
@@ -722,7 +827,15 @@ void init_object(py::module_ &m)
                 auto phbuf = get_stream_data(h, decode_level);
                 return phbuf;
             },
-            "Return a buffer protocol buffer describing the decoded stream.",
+            R"~~~(
+            Return a buffer protocol buffer describing the decoded stream.
+
+            Unlike :meth:`read_bytes`, the decoded data is not copied into a new
+            ``bytes`` object. The buffer is read-only and owns the decoded data, so it
+            remains valid after the stream or its ``Pdf`` is released. Use
+            ``memoryview()`` or pass it directly to NumPy, Pillow and similar
+            libraries to avoid copying large streams.
+            )~~~",
             py::arg("decode_level") = qpdf_dl_generalized)
         .def(
             "get_raw_stream_buffer",
@@ -730,7 +843,41 @@ void init_object(py::module_ &m)
                 PointerHolder<Buffer> phbuf = h.getRawStreamData();
                 return phbuf;
             },
-            "Return a buffer protocol buffer describing the raw, encoded stream")
+            "Return a read-only buffer protocol buffer describing the raw, encoded "
+            "stream")
+        .def(
+            "_pipe_stream_data",
+            [](QPDFObjectHandle &h,
+                py::object stream,
+                qpdf_stream_decode_level_e decode_level) {
+                // With no pipeline, qpdf only reports whether it can decode the
+                // stream at this level, without reading any data. It never
+                // filters at qpdf_dl_none, which is not an error.
+                bool filtered = false;
+                h.pipeStreamData(nullptr, &filtered, 0, decode_level);
+                if (decode_level != qpdf_dl_none && !filtered) {
+                    auto *owner = h.getOwningQPDF();
+                    throw QPDFExc(qpdf_e_unsupported,
+                        owner ? owner->getFilename() : "",
+                        std::string("object ") + h.getObjGen().unparse(),
+                        0,
+                        "open_reader called on unfilterable stream");
+                }
+                Pl_PythonOutput output("stream data", stream);
+                if (!h.pipeStreamData(&output, 0, decode_level)) {
+                    // qpdf has already warned; the output may be incomplete
+                    auto *owner = h.getOwningQPDF();
+                    throw QPDFExc(qpdf_e_damaged_pdf,
+                        owner ? owner->getFilename() : "",
+                        std::string("object ") + h.getObjGen().unparse(),
+                        0,
+                        "error decoding stream data for object " +
+                            h.getObjGen().unparse());
+                }
+            },
+            "Decode the stream and write it to a binary file-like object.",
+            py::arg("stream"),
+            py::arg("decode_level") = qpdf_dl_generalized)
         .def(
             "read_bytes",
             [](QPDFObjectHandle &h, qpdf_stream_decode_level_e decode_level) {
@@ -757,6 +904,8 @@ void init_object(py::module_ &m)
                 QPDFObjectHandle h_filter       = objecthandle_encode(filter);
                 QPDFObjectHandle h_decode_parms = objecthandle_encode(decode_parms);
                 h.replaceStreamData(sdata, h_filter, h_decode_parms);
+                note_stream_data(h);
+                journal_modified(h);
             },
             R"~~~(
             Low level write/replace stream data without argument checking. Use .write().
@@ -764,6 +913,28 @@ void init_object(py::module_ &m)
             py::arg("data"),
             py::arg("filter"),
             py::arg("decode_parms"))
+        .def(
+            "_write_from_provider",
+            [](QPDFObjectHandle &h,
+                py::function factory,
+                py::object filter,
+                py::object decode_parms) {
+                auto provider = PointerHolder<QPDFObjectHandle::StreamDataProvider>(
+                    new PythonStreamDataProvider(factory));
+                QPDFObjectHandle h_filter       = objecthandle_encode(filter);
+                QPDFObjectHandle h_decode_parms = objecthandle_encode(decode_parms);
+                h.replaceStreamData(provider, h_filter, h_decode_parms);
+                if (auto *owner = h.getOwningQPDF())
+                    get_pdf_state(*owner).calls_python = true;
+                note_stream_data(h, provider);
+                journal_modified(h);
+            },
+            R"~~~(
+            Low level replace stream data with data provided on demand. Use .write_from().
+            )~~~",
+            py::arg("factory"),
+            py::arg("filter"),
+            py::arg("decode_parms"))
         .def("_inline_image_raw_bytes",
             [](QPDFObjectHandle &h) { return py::bytes(h.getInlineImageValue()); })
         .def_property_readonly("_objgen", &object_get_objgen)
@@ -800,7 +971,8 @@ void init_object(py::module_ &m)
                 OperandGrouper og(whitelist);
                 h.parsePageContents(&og);
                 return og.getInstructions();
-            })
+            },
+            "Helper for parsing page contents; use ``pikepdf.parse_content_stream``.")
         .def_static("_parse_stream",
             &QPDFObjectHandle::parseContentStream,
             "Helper for parsing PDF content stream; use "
@@ -814,7 +986,9 @@ void init_object(py::module_ &m)
                     warn(og.getWarning());
                 }
                 return og.getInstructions();
-            })
+            },
+            "Helper for parsing PDF content stream; use "
+            "``pikepdf.parse_content_stream``.")
         .def(
             "unparse",
             [](QPDFObjectHandle &h, bool resolved) -> py::bytes {
@@ -916,8 +1090,11 @@ void init_object(py::module_ &m)
         "_new_stream",
         [](std::shared_ptr<QPDF> owner, py::bytes data) {
             std::string s = data;
-            return QPDFObjectHandle::newStream(owner.get(),
+            auto stream   = QPDFObjectHandle::newStream(owner.get(),
                 data); // This makes a copy of the data
+            note_stream_data(stream);
+            journal_created(stream);
+            return stream;
         },
         "Construct a PDF Stream object from binary data",
         py::keep_alive<0, 1>() // returned object references the owner
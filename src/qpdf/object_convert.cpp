@@ -32,16 +32,31 @@
 
 extern uint DECIMAL_PRECISION;
 
+// Python objects that conversion needs, looked up once by init_object_convert() so
+// that encoding a value does not import modules or look up attributes. They are
+// deliberately leaked, so they remain valid during interpreter shutdown.
+static py::handle decimal_getcontext;
+static py::handle Decimal;
+static py::handle Object_type;
+
+void init_object_convert(py::module_ &m)
+{
+    auto decimal_module = py::module_::import("decimal");
+    decimal_getcontext  = decimal_module.attr("getcontext").release();
+    Decimal             = decimal_module.attr("Decimal").release();
+    Object_type         = py::type::of<QPDFObjectHandle>().release();
+}
+
 std::map<std::string, QPDFObjectHandle> dict_builder(const py::dict dict)
 {
     StackGuard sg(" dict_builder");
-    std::map<std::string, QPDFObjectHandle> result;
+    if (PyErr_Occurred())
+        throw py::error_already_set(); // Recursion limit
 
+    std::map<std::string, QPDFObjectHandle> result;
     for (const auto &item : dict) {
         std::string key = item.first.cast<std::string>();
-
-        auto value  = objecthandle_encode(item.second);
-        result[key] = value;
+        result.emplace(std::move(key), objecthandle_encode(item.second));
     }
     return result;
 }
@@ -49,14 +64,14 @@ std::map<std::string, QPDFObjectHandle> dict_builder(const py::dict dict)
 std::vector<QPDFObjectHandle> array_builder(const py::iterable iter)
 {
     StackGuard sg(" array_builder");
+    if (PyErr_Occurred())
+        throw py::error_already_set(); // Recursion limit
+
     std::vector<QPDFObjectHandle> result;
-    int narg = 0;
+    result.reserve(py::len_hint(iter));
 
     for (const auto &item : iter) {
-        narg++;
-
-        auto value = objecthandle_encode(item);
-        result.push_back(value);
+        result.emplace_back(objecthandle_encode(item));
     }
     return result;
 }
@@ -64,7 +79,7 @@ std::vector<QPDFObjectHandle> array_builder(const py::iterable iter)
 class DecimalPrecision {
 public:
     DecimalPrecision(uint calc_precision)
-        : decimal_context(py::module_::import("decimal").attr("getcontext")()),
+        : decimal_context(decimal_getcontext()),
           saved_precision(decimal_context.attr("prec").cast<uint>())
     {
         decimal_context.attr("prec") = calc_precision;
@@ -80,10 +95,70 @@ private:
     uint saved_precision;
 };
 
+static QPDFObjectHandle encode_decimal(const py::handle handle)
+{
+    DecimalPrecision dp(DECIMAL_PRECISION);
+    auto rounded = py::reinterpret_steal<py::object>(PyNumber_Positive(handle.ptr()));
+    if (!rounded)
+        throw py::error_already_set();
+    if (!rounded.attr("is_finite")().cast<bool>())
+        throw py::value_error("Can't convert NaN or Infinity to PDF real number");
+    return QPDFObjectHandle::newReal(py::str(rounded));
+}
+
+static QPDFObjectHandle encode_double(double value)
+{
+    if (!std::isfinite(value))
+        throw py::value_error("Can't convert NaN or Infinity to PDF real number");
+    return QPDFObjectHandle::newReal(value);
+}
+
+// Encode values whose type is exactly one of the types we convert, which covers
+// nearly everything in practice, without any isinstance() or attribute checks.
+// Returns false if the type is something else, including a subclass.
+static bool encode_exact_type(const py::handle handle, QPDFObjectHandle &result)
+{
+    auto *type = Py_TYPE(handle.ptr());
+
+    if (type == reinterpret_cast<PyTypeObject *>(Object_type.ptr())) {
+        result = handle.cast<QPDFObjectHandle>();
+    } else if (handle.is_none()) {
+        result = QPDFObjectHandle::newNull();
+    } else if (type == &PyBool_Type) {
+        result = QPDFObjectHandle::newBool(handle.ptr() == Py_True);
+    } else if (type == &PyLong_Type) {
+        result = QPDFObjectHandle::newInteger(handle.cast<long long>());
+    } else if (type == &PyFloat_Type) {
+        result = encode_double(PyFloat_AS_DOUBLE(handle.ptr()));
+    } else if (type == &PyUnicode_Type) {
+        result = QPDFObjectHandle::newUnicodeString(
+            static_cast<std::string>(py::reinterpret_borrow<py::str>(handle)));
+    } else if (type == &PyBytes_Type) {
+        result = QPDFObjectHandle::newString(
+            std::string(PyBytes_AS_STRING(handle.ptr()),
+                static_cast<size_t>(PyBytes_GET_SIZE(handle.ptr()))));
+    } else if (type == &PyList_Type || type == &PyTuple_Type) {
+        result = QPDFObjectHandle::newArray(
+            array_builder(py::reinterpret_borrow<py::iterable>(handle)));
+    } else if (type == &PyDict_Type) {
+        result = QPDFObjectHandle::newDictionary(
+            dict_builder(py::reinterpret_borrow<py::dict>(handle)));
+    } else if (type == reinterpret_cast<PyTypeObject *>(Decimal.ptr())) {
+        result = encode_decimal(handle);
+    } else {
+        return false;
+    }
+    return true;
+}
+
 QPDFObjectHandle objecthandle_encode(const py::handle handle)
 {
-    if (handle.is_none())
-        return QPDFObjectHandle::newNull();
+    QPDFObjectHandle result;
+    if (encode_exact_type(handle, result))
+        return result;
+
+    // Otherwise, handle subclasses and other types that behave like the ones we
+    // know, as the exact type checks above would have
 
     // Ensure that when we return QPDFObjectHandle/pikepdf.Object to the Py
     // environment, that we can recover it
@@ -99,23 +174,13 @@ QPDFObjectHandle objecthandle_encode(const py::handle handle)
         return QPDFObjectHandle::newBool(as_bool);
     }
 
-    auto decimal_module = py::module_::import("decimal");
-    auto Decimal        = decimal_module.attr("Decimal");
     if (py::isinstance(handle, Decimal)) {
-        DecimalPrecision dp(DECIMAL_PRECISION);
-        auto rounded =
-            py::reinterpret_steal<py::object>(PyNumber_Positive(handle.ptr()));
-        if (!rounded.attr("is_finite")().cast<bool>())
-            throw py::value_error("Can't convert NaN or Infinity to PDF real number");
-        return QPDFObjectHandle::newReal(py::str(rounded));
+        return encode_decimal(handle);
     } else if (py::isinstance<py::int_>(handle)) {
         auto as_int = handle.cast<long long>();
         return QPDFObjectHandle::newInteger(as_int);
     } else if (py::isinstance<py::float_>(handle)) {
-        auto as_double = handle.cast<double>();
-        if (!std::isfinite(as_double))
-            throw py::value_error("Can't convert NaN or Infinity to PDF real number");
-        return QPDFObjectHandle::newReal(as_double);
+        return encode_double(handle.cast<double>());
     }
 
     py::object obj = py::reinterpret_borrow<py::object>(handle);
@@ -148,7 +213,7 @@ QPDFObjectHandle objecthandle_encode(const py::handle handle)
 
 py::object decimal_from_pdfobject(QPDFObjectHandle h)
 {
-    auto decimal_constructor = py::module_::import("decimal").attr("Decimal");
+    auto decimal_constructor = Decimal;
 
     if (h.getTypeCode() == QPDFObject::object_type_e::ot_integer) {
         auto value = h.getIntValue();
@@ -0,0 +1,608 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+/*
+ * Implement Object.content_digest()
+ *
+ * An object is digested by feeding a canonical serialization of it to SHA-256.
+ * Objects that compare equal with == have the same serialization: integers and
+ * reals with the same value are written the same way, and strings are written
+ * as UTF-8. Indirect objects are digested separately and their digest is written
+ * in place of the reference, so identical objects with different object numbers
+ * (or in different Pdfs) have the same digest.
+ *
+ * Indirect objects are visited without recursion, using Tarjan's algorithm to
+ * find the groups of objects that refer to each other (cycles, such as a page
+ * tree or an outline with /Parent, /Prev and /Next). Each object is serialized
+ * once. An object that is not part of a cycle is digested as soon as everything
+ * it refers to has been. The digest of an object in a cycle covers every object
+ * of the cycle in the order they are reached from it, with references inside
+ * the cycle written as those positions; it is only calculated when needed.
+ *
+ * Pdf.deduplicate() uses the same digests to find identical resources and point
+ * every reference at one of them.
+ */
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <qpdf/Buffer.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/Pl_SHA2.hh>
+
+#include "pikepdf.h"
+#include "qpdf_state.h"
+
+using ObjGenPositions = std::unordered_map<QPDFObjGen, size_t, ObjGenHash>;
+
+// Optional content groups and membership dictionaries are told apart by their
+// identity: two layers with the same name are still different layers
+static bool is_optional_content(QPDFObjectHandle h)
+{
+    if (!h.isDictionary())
+        return false;
+    auto type = h.getKey("/Type");
+    return type.isName() && (type.getName() == "/OCG" || type.getName() == "/OCMD");
+}
+
+class ObjectDigester {
+public:
+    ObjectDigester(bool decode, DigestCache *cache, bool exact = false)
+        : decode(decode), cache(cache), exact(exact)
+    {
+    }
+
+    std::string digest(QPDFObjectHandle h)
+    {
+        if (h.isIndirect())
+            return this->digest_indirect(h);
+        Body body;
+        this->write(body, h);
+        for (auto &ref : body.refs)
+            this->digest_indirect(ref);
+        Pl_SHA2 sha(256);
+        this->write_body(sha, body, nullptr);
+        sha.finish();
+        return sha.getRawDigest();
+    }
+
+private:
+    // The serialization of one object, with holes for its references to
+    // indirect objects: text[0], refs[0], text[1], ..., text[n], then the
+    // stream data, if any
+    struct Body {
+        std::vector<std::string> text{std::string()};
+        std::vector<QPDFObjectHandle> refs;
+        PointerHolder<Buffer> data;
+    };
+
+    // An object whose cycle Tarjan's algorithm has not finished
+    struct Node {
+        Body body;
+        size_t index;
+        size_t lowlink;
+        size_t next_ref = 0;
+    };
+
+    // An object in a cycle, kept until its digest is needed
+    struct CycleMember {
+        Body body;
+        size_t cycle;
+    };
+
+    static void write_bytes(Pl_SHA2 &sha, const std::string &s)
+    {
+        sha.write(reinterpret_cast<unsigned char *>(const_cast<char *>(s.data())),
+            s.size());
+    }
+
+    // A type tag, the length of the value and the value
+    static void write_item(std::string &out, char tag, const std::string &value)
+    {
+        out += tag;
+        out += std::to_string(value.size());
+        out += ':';
+        out += value;
+    }
+
+    static void write_item(Body &body, char tag, const std::string &value)
+    {
+        write_item(body.text.back(), tag, value);
+    }
+
+    // Write a real as an integer if it has an integral value, and otherwise
+    // without redundant zeros or signs
+    static void write_real(Body &body, std::string value)
+    {
+        bool negative = false;
+        if (!value.empty() && (value[0] == '-' || value[0] == '+')) {
+            negative = value[0] == '-';
+            value.erase(0, 1);
+        }
+        auto point = value.find('.');
+        if (point != std::string::npos) {
+            value.erase(value.find_last_not_of('0') + 1);
+            if (!value.empty() && value.back() == '.')
+                value.pop_back();
+        }
+        value.erase(0, std::min(value.find_first_not_of('0'), value.size()));
+        if (value.empty() || value[0] == '.')
+            value.insert(0, "0");
+        if (negative && value != "0")
+            value.insert(0, "-");
+        write_item(body, value.find('.') == std::string::npos ? 'i' : 'f', value);
+    }
+
+    void write(Body &body, QPDFObjectHandle h)
+    {
+        StackGuard sg(" content_digest");
+        if (PyErr_Occurred())
+            throw py::error_already_set(); // Recursion limit
+
+        if (h.isIndirect()) {
+            body.refs.push_back(h);
+            body.text.emplace_back();
+            return;
+        }
+
+        switch (h.getTypeCode()) {
+        case QPDFObject::ot_null:
+            write_item(body, 'n', "");
+            break;
+        case QPDFObject::ot_boolean:
+            write_item(body, 'b', h.getBoolValue() ? "1" : "0");
+            break;
+        case QPDFObject::ot_integer:
+            write_item(body, 'i', std::to_string(h.getIntValue()));
+            break;
+        case QPDFObject::ot_real:
+            write_real(body, h.getRealValue());
+            break;
+        case QPDFObject::ot_string:
+            // Different strings can have the same text, e.g. when their bytes
+            // are not valid PDFDocEncoding or UTF-16
+            write_item(body, 's', this->exact ? h.getStringValue() : h.getUTF8Value());
+            break;
+        case QPDFObject::ot_name:
+            write_item(body, 'N', h.getName());
+            break;
+        case QPDFObject::ot_operator:
+            write_item(body, 'o', h.getOperatorValue());
+            break;
+        case QPDFObject::ot_array: {
+            auto items = h.getArrayAsVector();
+            write_item(body, 'a', std::to_string(items.size()));
+            for (auto &item : items)
+                this->write(body, item);
+            break;
+        }
+        case QPDFObject::ot_dictionary:
+            this->write_dict(body, h, {});
+            break;
+        case QPDFObject::ot_stream:
+            this->write_stream(body, h);
+            break;
+        default:
+            throw py::type_error(
+                "cannot digest " + objecthandle_pythonic_typename(h) + " objects");
+        }
+    }
+
+    void write_dict(
+        Body &body, QPDFObjectHandle h, const std::vector<std::string> &skip_keys)
+    {
+        // getDictAsMap is ordered by key, which makes the serialization canonical
+        auto items = h.getDictAsMap();
+        for (auto &key : skip_keys)
+            items.erase(key);
+        write_item(body, 'd', std::to_string(items.size()));
+        for (auto &item : items) {
+            write_item(body, 'N', item.first);
+            this->write(body, item.second);
+        }
+    }
+
+    void write_stream(Body &body, QPDFObjectHandle h)
+    {
+        // /Length describes the encoded data, and so do /Filter and /DecodeParms
+        // when the decoded data is used. Streams that cannot be decoded are
+        // digested as they are stored.
+        PointerHolder<Buffer> data;
+        bool decoded = false;
+        if (this->decode) {
+            try {
+                data    = h.getStreamData(qpdf_dl_generalized);
+                decoded = true;
+            } catch (const QPDFExc &) {
+            }
+        }
+        if (!decoded)
+            data = h.getRawStreamData();
+
+        if (decoded) {
+            write_item(body, 'D', "");
+            this->write_dict(body, h.getDict(), {"/Length", "/Filter", "/DecodeParms"});
+        } else {
+            write_item(body, 'S', "");
+            this->write_dict(body, h.getDict(), {"/Length"});
+        }
+        body.text.back() += "x" + std::to_string(data->getSize()) + ":";
+        body.data = data;
+    }
+
+    // Write the object that the indirect handle h refers to
+    void write_direct(Body &body, QPDFObjectHandle h)
+    {
+        if (this->exact && is_optional_content(h)) {
+            auto og = h.getObjGen();
+            write_item(body,
+                'I',
+                std::to_string(og.getObj()) + " " + std::to_string(og.getGen()));
+        } else if (h.isStream()) {
+            this->write_stream(body, h);
+        } else if (h.isDictionary()) {
+            this->write_dict(body, h, {});
+        } else {
+            this->write(body, h.shallowCopy());
+        }
+    }
+
+    // Hash a body. References to objects in cycle_positions are written as
+    // their position; everything else referenced must already be in memo.
+    void write_body(
+        Pl_SHA2 &sha, const Body &body, const ObjGenPositions *cycle_positions)
+    {
+        std::string ref_item;
+        for (size_t i = 0; i < body.text.size(); ++i) {
+            write_bytes(sha, body.text[i]);
+            if (i == body.refs.size())
+                break;
+            auto og = body.refs[i].getObjGen();
+            ref_item.clear();
+            if (cycle_positions && cycle_positions->count(og))
+                write_item(ref_item, 'r', std::to_string(cycle_positions->at(og)));
+            else
+                write_item(ref_item, 'R', this->memo.at(og));
+            write_bytes(sha, ref_item);
+        }
+        if (body.data.getPointer())
+            sha.write(body.data->getBuffer(), body.data->getSize());
+    }
+
+    void remember(QPDFObjGen og, const std::string &digest)
+    {
+        this->memo[og] = digest;
+        if (this->cache)
+            (*this->cache)[og] = digest;
+    }
+
+    // True if og has been digested, or is in a cycle that has been visited
+    bool visited(QPDFObjGen og)
+    {
+        if (this->memo.count(og) || this->cycle_members.count(og))
+            return true;
+        if (this->cache) {
+            auto cached = this->cache->find(og);
+            if (cached != this->cache->end()) {
+                this->memo[og] = cached->second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The digest of a visited object
+    std::string digest_of(QPDFObjGen og)
+    {
+        auto remembered = this->memo.find(og);
+        if (remembered != this->memo.end())
+            return remembered->second;
+        return this->digest_cycle(og);
+    }
+
+    std::string digest_indirect(QPDFObjectHandle h)
+    {
+        auto og = h.getObjGen();
+        if (!this->visited(og)) {
+            try {
+                this->visit(h);
+            } catch (...) {
+                this->nodes.clear();
+                this->tarjan_stack.clear();
+                this->path.clear();
+                throw;
+            }
+        }
+        return this->digest_of(og);
+    }
+
+    // Tarjan's strongly connected components algorithm, with an explicit stack
+    // in place of recursion
+    void visit(QPDFObjectHandle h)
+    {
+        this->enter(h);
+        while (!this->path.empty()) {
+            auto og    = this->path.back();
+            auto &node = this->nodes.at(og);
+            if (node.next_ref < node.body.refs.size()) {
+                auto ref    = node.body.refs[node.next_ref++];
+                auto ref_og = ref.getObjGen();
+                if (this->visited(ref_og))
+                    continue;
+                // Every object in nodes is on the Tarjan stack
+                auto found = this->nodes.find(ref_og);
+                if (found == this->nodes.end())
+                    this->enter(ref);
+                else
+                    node.lowlink = std::min(node.lowlink, found->second.index);
+                continue;
+            }
+            this->path.pop_back();
+            if (!this->path.empty()) {
+                auto &parent   = this->nodes.at(this->path.back());
+                parent.lowlink = std::min(parent.lowlink, node.lowlink);
+            }
+            if (node.lowlink == node.index)
+                this->finish(og);
+        }
+    }
+
+    void enter(QPDFObjectHandle h)
+    {
+        Node node;
+        node.index = node.lowlink = this->next_index++;
+        this->write_direct(node.body, h);
+        auto og = h.getObjGen();
+        this->nodes.emplace(og, std::move(node));
+        this->tarjan_stack.push_back(og);
+        this->path.push_back(og);
+    }
+
+    // Every object that the objects from root up the Tarjan stack refer to has
+    // been visited, so they can be digested, or set aside as a cycle
+    void finish(QPDFObjGen root)
+    {
+        std::vector<QPDFObjGen> members;
+        QPDFObjGen og;
+        do {
+            og = this->tarjan_stack.back();
+            this->tarjan_stack.pop_back();
+            members.push_back(og);
+        } while (!(og == root));
+
+        auto &root_body = this->nodes.at(root).body;
+        bool cyclic     = members.size() > 1 ||
+                      std::any_of(root_body.refs.begin(),
+                          root_body.refs.end(),
+                          [&](QPDFObjectHandle ref) { return ref.getObjGen() == root; });
+        if (!cyclic) {
+            for (auto &ref : root_body.refs)
+                this->digest_of(ref.getObjGen());
+            Pl_SHA2 sha(256);
+            this->write_body(sha, root_body, nullptr);
+            sha.finish();
+            this->remember(root, sha.getRawDigest());
+            this->nodes.erase(root);
+            return;
+        }
+
+        size_t cycle = this->next_cycle++;
+        for (auto &member : members) {
+            this->cycle_members.emplace(
+                member, CycleMember{std::move(this->nodes.at(member).body), cycle});
+            this->nodes.erase(member);
+        }
+        // Digest whatever the cycle refers to outside itself now, so that
+        // digest_cycle() never needs to recurse
+        for (auto &member : members) {
+            for (auto &ref : this->cycle_members.at(member).body.refs) {
+                auto found = this->cycle_members.find(ref.getObjGen());
+                if (found == this->cycle_members.end() || found->second.cycle != cycle)
+                    this->digest_of(ref.getObjGen());
+            }
+        }
+    }
+
+    std::string digest_cycle(QPDFObjGen start)
+    {
+        auto cycle = this->cycle_members.at(start).cycle;
+
+        // Number the members of the cycle breadth first from start
+        std::vector<QPDFObjGen> order{start};
+        ObjGenPositions positions{{start, 0}};
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (auto &ref : this->cycle_members.at(order[i]).body.refs) {
+                auto ref_og = ref.getObjGen();
+                auto found  = this->cycle_members.find(ref_og);
+                if (found != this->cycle_members.end() &&
+                    found->second.cycle == cycle &&
+                    positions.emplace(ref_og, order.size()).second)
+                    order.push_back(ref_og);
+            }
+        }
+
+        Pl_SHA2 sha(256);
+        std::string header;
+        write_item(header, 'c', std::to_string(order.size()));
+        write_bytes(sha, header);
+        for (auto &og : order)
+            this->write_body(sha, this->cycle_members.at(og).body, &positions);
+        sha.finish();
+        auto digest = sha.getRawDigest();
+        this->remember(start, digest);
+        return digest;
+    }
+
+    const bool decode;
+    DigestCache *cache;
+    // Digest optional content by object number, and strings by their bytes
+    const bool exact;
+    std::unordered_map<QPDFObjGen, std::string, ObjGenHash> memo;
+    std::unordered_map<QPDFObjGen, CycleMember, ObjGenHash> cycle_members;
+    std::unordered_map<QPDFObjGen, Node, ObjGenHash> nodes;
+    std::vector<QPDFObjGen> tarjan_stack;
+    std::vector<QPDFObjGen> path;
+    size_t next_index = 0;
+    size_t next_cycle = 0;
+};
+
+py::bytes objecthandle_digest(QPDFObjectHandle h, bool decode, bool use_cache)
+{
+    DigestCache *cache = nullptr;
+    auto *owner        = h.getOwningQPDF();
+    if (use_cache && owner) {
+        auto &state = get_pdf_state(*owner);
+        cache       = decode ? &state.decoded_digests : &state.raw_digests;
+    }
+    ObjectDigester digester(decode, cache);
+    return py::bytes(digester.digest(h));
+}
+
+using ObjGenMap = std::unordered_map<QPDFObjGen, QPDFObjectHandle, ObjGenHash>;
+
+// Indirect objects reachable from the /Resources of every page: fonts, images,
+// color spaces and so on. Pages are not followed, so that page-specific objects
+// such as annotations are never candidates, and neither is optional content.
+static std::vector<QPDFObjectHandle> page_resources(QPDF &q)
+{
+    std::vector<QPDFObjectHandle> found;
+    std::unordered_set<QPDFObjGen, ObjGenHash> seen;
+    std::vector<QPDFObjectHandle> pending;
+    for (auto &page : q.getAllPages())
+        pending.push_back(page.getKey("/Resources"));
+
+    while (!pending.empty()) {
+        auto h = pending.back();
+        pending.pop_back();
+        if (h.isIndirect()) {
+            if (!seen.insert(h.getObjGen()).second || h.isPageObject() ||
+                h.isPagesObject() || is_optional_content(h))
+                continue;
+            found.push_back(h);
+        }
+        if (h.isStream())
+            h = h.getDict();
+        if (h.isArray()) {
+            for (auto &item : h.getArrayAsVector())
+                pending.push_back(item);
+        } else if (h.isDictionary()) {
+            for (auto &item : h.getDictAsMap())
+                pending.push_back(item.second);
+        }
+    }
+    return found;
+}
+
+// Roughly how many bytes h takes up in a PDF, ignoring compression of
+// object streams
+static size_t serialized_size(QPDFObjectHandle h)
+{
+    if (!h.isStream())
+        return h.unparseResolved().size();
+    auto dict   = h.getDict();
+    auto length = dict.getKey("/Length");
+    size_t data = length.isInteger() && length.getIntValue() >= 0
+                      ? static_cast<size_t>(length.getIntValue())
+                      : h.getRawStreamData()->getSize();
+    return dict.unparse().size() + data;
+}
+
+// Point references inside h, and inside the direct objects it contains, at their
+// replacements. Returns true if anything changed.
+static bool replace_references(QPDFObjectHandle h, const ObjGenMap &replacements)
+{
+    StackGuard sg(" deduplicate");
+    if (PyErr_Occurred())
+        throw py::error_already_set(); // Recursion limit
+
+    auto replacement_for = [&](QPDFObjectHandle item, bool &changed) {
+        if (item.isIndirect()) {
+            auto found = replacements.find(item.getObjGen());
+            if (found != replacements.end()) {
+                changed = true;
+                return found->second;
+            }
+        } else if (item.isArray() || item.isDictionary()) {
+            changed = replace_references(item, replacements) || changed;
+        }
+        return item;
+    };
+
+    bool changed = false;
+    if (h.isStream())
+        return replace_references(h.getDict(), replacements);
+    if (h.isArray()) {
+        int n = h.getArrayNItems();
+        for (int i = 0; i < n; ++i) {
+            bool replaced = false;
+            auto item     = replacement_for(h.getArrayItem(i), replaced);
+            if (replaced)
+                h.setArrayItem(i, item);
+            changed = changed || replaced;
+        }
+    } else if (h.isDictionary()) {
+        for (auto &key : h.getKeys()) {
+            bool replaced = false;
+            auto item     = replacement_for(h.getKey(key), replaced);
+            if (replaced)
+                h.replaceKey(key, item);
+            changed = changed || replaced;
+        }
+    }
+    return changed;
+}
+
+size_t deduplicate_objects(QPDF &q)
+{
+    // Identical resources are grouped by digest; the one with the lowest object
+    // number is kept
+    std::vector<QPDFObjectHandle> candidates = page_resources(q);
+    std::sort(candidates.begin(),
+        candidates.end(),
+        [](QPDFObjectHandle a, QPDFObjectHandle b) {
+            return a.getObjGen() < b.getObjGen();
+        });
+
+    // Resources that refer to different optional content groups, or hold
+    // strings with different bytes, stay apart
+    ObjectDigester digester(false, nullptr, true);
+    std::map<std::string, QPDFObjectHandle> kept;
+    ObjGenMap replacements;
+    size_t bytes_saved = 0;
+    for (auto &h : candidates) {
+        std::string digest;
+        try {
+            digest = digester.digest(h);
+        } catch (const QPDFExc &) {
+            continue; // Unreadable stream data; leave it alone
+        } catch (const py::type_error &) {
+            continue; // Reserved or uninitialized object
+        }
+        auto inserted = kept.emplace(digest, h);
+        if (inserted.second)
+            continue;
+        replacements[h.getObjGen()] = inserted.first->second;
+        bytes_saved += serialized_size(h);
+    }
+    if (replacements.empty())
+        return 0;
+
+    // Duplicates may be referenced from anywhere, not only from resources. Once
+    // nothing refers to them, QPDFWriter leaves them out.
+    for (auto &h : q.getAllObjects())
+        if (replace_references(h, replacements))
+            journal_modified(h);
+    auto trailer = q.getTrailer();
+    replace_references(trailer, replacements);
+    return bytes_saved;
+}
@@ -10,32 +10,27 @@
 #include <iostream>
 #include <iomanip>
 #include <cctype>
+#include <algorithm>
+#include <exception>
+#include <set>
 
 #include "pikepdf.h"
 #include "parsers.h"
+#include "qpdf_state.h"
+#include "tokenfilter.h"
 
 #include <qpdf/QPDFPageObjectHelper.hh>
 #include <qpdf/QPDFPageLabelDocumentHelper.hh>
 #include <qpdf/Pipeline.hh>
 #include <qpdf/Pl_Buffer.hh>
+#include <qpdf/Pl_Discard.hh>
+#include <qpdf/Pl_QPDFTokenizer.hh>
 
 size_t page_index(QPDF &owner, QPDFObjectHandle page)
 {
     if (&owner != page.getOwningQPDF())
         throw py::value_error("Page is not in this Pdf");
-    auto all_pages = owner.getAllPages();
-
-    auto page_objgen = page.getObjGen();
-    auto it          = std::find_if(all_pages.begin(),
-        all_pages.end(),
-        [&page_objgen](const QPDFObjectHandle &iter_page) {
-            return (page_objgen == iter_page.getObjGen());
-        });
-    if (it == all_pages.end())
-        throw py::value_error("Page is not consistently registered with Pdf");
-    auto idx = it - all_pages.begin();
-    assert(idx >= 0);
-    return idx;
+    return get_pdf_state(owner).page_index.find(owner, page.getObjGen());
 }
 
 std::string label_string_from_dict(QPDFObjectHandle label_dict)
@@ -46,6 +41,179 @@ std::string label_string_from_dict(QPDFObjectHandle label_dict)
     return result;
 }
 
+// Collects every name in a content stream. Names that are not resource names are
+// collected too, which only means that fewer resources are removed.
+class NameCollector : public QPDFObjectHandle::TokenFilter {
+public:
+    void handleToken(QPDFTokenizer::Token const &token) override
+    {
+        if (token.getType() == QPDFTokenizer::tt_name)
+            this->names.insert(token.getValue());
+    }
+
+    std::set<std::string> names;
+};
+
+static std::set<std::string> content_names(const std::string &content)
+{
+    NameCollector collector;
+    Pl_Discard discard;
+    Pl_QPDFTokenizer tokenizer("content names", &collector, &discard);
+    tokenizer.write(
+        reinterpret_cast<unsigned char *>(const_cast<char *>(content.data())),
+        content.size());
+    tokenizer.finish();
+    return std::move(collector.names);
+}
+
+// A Form XObject without its own /Resources uses the resources of the page that
+// draws it, so the page's content alone does not say which resources are used.
+static bool uses_page_resources(QPDFObjectHandle resources)
+{
+    auto xobjects = resources.getKey("/XObject");
+    if (!xobjects.isDictionary())
+        return false;
+    for (auto &key : xobjects.getKeys()) {
+        auto xobj = xobjects.getKey(key);
+        if (xobj.isStream()) {
+            auto dict = xobj.getDict();
+            if (dict.getKey("/Subtype").isName() &&
+                dict.getKey("/Subtype").getName() == "/Form" &&
+                !dict.getKey("/Resources").isDictionary())
+                return true;
+        }
+    }
+    return false;
+}
+
+// Like QPDFPageObjectHelper::removeUnreferencedResources, but with the names
+// already known. Resource dictionaries may be shared with other pages, so they
+// are replaced with new dictionaries rather than modified.
+static void remove_resources_except(
+    QPDFObjectHandle page, const std::set<std::string> &names)
+{
+    static const char *resource_types[] = {"/ExtGState",
+        "/ColorSpace",
+        "/Pattern",
+        "/Shading",
+        "/XObject",
+        "/Font",
+        "/Properties"};
+
+    auto resources = page.getKey("/Resources");
+    if (!resources.isDictionary() || uses_page_resources(resources))
+        return;
+
+    auto new_resources = QPDFObjectHandle::newDictionary(resources.getDictAsMap());
+    bool changed       = false;
+    for (auto type : resource_types) {
+        auto dict = resources.getKey(type);
+        if (!dict.isDictionary())
+            continue;
+        auto keys = dict.getKeys();
+        std::map<std::string, QPDFObjectHandle> kept;
+        for (auto &key : keys)
+            if (names.count(key))
+                kept[key] = dict.getKey(key);
+        if (kept.size() != keys.size()) {
+            new_resources.replaceKey(type, QPDFObjectHandle::newDictionary(kept));
+            changed = true;
+        }
+    }
+    if (changed)
+        page.replaceKey("/Resources", new_resources);
+}
+
+struct PageWork {
+    QPDFObjectHandle page;
+    std::string content;
+    std::set<std::string> names;
+    std::exception_ptr error;
+};
+
+void map_pages_native(QPDF &q, const std::vector<NativePageOp> &ops, size_t workers)
+{
+    if (workers == 0)
+        throw py::value_error("workers must be at least 1");
+
+    bool rewrite_contents = false, remove_resources = false;
+    for (auto &op : ops) {
+        if (op.kind == NativePageOp::remove_unreferenced_resources)
+            remove_resources = true;
+        else
+            rewrite_contents = true;
+    }
+    if (!rewrite_contents && !remove_resources)
+        return;
+
+    // Reading pages and their content streams uses the QPDF, as saving does
+    PdfSaveLock save_lock(q);
+
+    std::vector<PageWork> work;
+
+    // Content streams are read and decoded one at a time, because a QPDF cannot
+    // be used from several threads
+    auto read_pages = [&] {
+        for (auto &page : q.getAllPages()) {
+            Pl_Buffer buffer("page contents");
+            QPDFPageObjectHelper(page).pipePageContents(&buffer);
+            PointerHolder<Buffer> buf(buffer.getBuffer());
+            work.push_back({page,
+                std::string(
+                    reinterpret_cast<const char *>(buf->getBuffer()), buf->getSize()),
+                {},
+                nullptr});
+        }
+    };
+    // As in save_pdf(), the GIL is kept if reading q may call into Python: a
+    // Python input source, Python token filters or stream data providers
+    if (pdf_calls_python(q)) {
+        read_pages();
+    } else {
+        py::gil_scoped_release release;
+        read_pages();
+    }
+
+    {
+        py::gil_scoped_release release;
+
+        // The content streams are now plain bytes, so they can be tokenized and
+        // filtered in parallel
+        std::atomic<size_t> next_page{0};
+        auto worker = [&](size_t) {
+            for (size_t index = next_page++; index < work.size();
+                 index        = next_page++) {
+                auto &item = work[index];
+                try {
+                    for (auto &op : ops)
+                        if (op.kind == NativePageOp::content_rules)
+                            item.content = ContentRules::apply(op.rules, item.content);
+                    if (remove_resources)
+                        item.names = content_names(item.content);
+                } catch (...) {
+                    item.error = std::current_exception();
+                }
+            }
+        };
+        run_workers(std::max<size_t>(1, std::min(workers, work.size())), worker);
+    }
+
+    for (auto &item : work)
+        if (item.error)
+            std::rethrow_exception(item.error);
+
+    // Commit the changes, in page order
+    for (auto &item : work) {
+        if (rewrite_contents) {
+            auto contents = QPDFObjectHandle::newStream(&q, item.content);
+            note_stream_data(contents);
+            item.page.replaceKey("/Contents", contents);
+        }
+        if (remove_resources)
+            remove_resources_except(item.page, item.names);
+    }
+}
+
 void init_page(py::module_ &m)
 {
     py::class_<QPDFPageObjectHelper>(m, "Page")
@@ -72,7 +240,10 @@ void init_page(py::module_ &m)
         .def(
             "externalize_inline_images",
             [](QPDFPageObjectHelper &poh, size_t min_size = 0) {
-                return poh.externalizeInlineImages(min_size);
+                poh.externalizeInlineImages(min_size);
+                journal_updated(poh.getObjectHandle());
+                if (auto *q = poh.getObjectHandle().getOwningQPDF())
+                    journal_incomplete(*q); // The resources may be shared
             },
             py::arg("min_size") = 0,
             R"~~~(
@@ -81,8 +252,12 @@ void init_page(py::module_ &m)
                 Args:
                     min_size (int): minimum size in bytes
             )~~~")
-        .def("rotate",
-            &QPDFPageObjectHelper::rotatePage,
+        .def(
+            "rotate",
+            [](QPDFPageObjectHelper &poh, int angle, bool relative) {
+                poh.rotatePage(angle, relative);
+                journal_modified(poh.getObjectHandle());
+            },
             py::arg("angle"),
             py::arg("relative"),
             R"~~~(
@@ -93,8 +268,12 @@ void init_page(py::module_ &m)
                 page. ``angle`` must be a multiple of ``90``. Adding ``90`` to
                 the rotation rotates clockwise by ``90`` degrees.
             )~~~")
-        .def("contents_coalesce",
-            &QPDFPageObjectHelper::coalesceContentStreams,
+        .def(
+            "contents_coalesce",
+            [](QPDFPageObjectHelper &poh) {
+                poh.coalesceContentStreams();
+                journal_updated(poh.getObjectHandle());
+            },
             R"~~~(
                 Coalesce a page's content streams.
 
@@ -108,7 +287,8 @@ void init_page(py::module_ &m)
         .def(
             "_contents_add",
             [](QPDFPageObjectHelper &poh, QPDFObjectHandle &contents, bool prepend) {
-                return poh.addPageContents(contents, prepend);
+                poh.addPageContents(contents, prepend);
+                journal_updated(poh.getObjectHandle());
             },
             py::arg("contents"),
             py::kw_only(),
@@ -124,13 +304,20 @@ void init_page(py::module_ &m)
                     // LCOV_EXCL_STOP
                 }
                 auto stream = QPDFObjectHandle::newStream(q, contents);
-                return poh.addPageContents(stream, prepend);
+                note_stream_data(stream);
+                poh.addPageContents(stream, prepend);
+                journal_updated(poh.getObjectHandle());
             },
             py::arg("contents"),
             py::kw_only(),
             py::arg("prepend") = false)
-        .def("remove_unreferenced_resources",
-            &QPDFPageObjectHelper::removeUnreferencedResources,
+        .def(
+            "remove_unreferenced_resources",
+            [](QPDFPageObjectHelper &poh) {
+                poh.removeUnreferencedResources();
+                if (auto *q = poh.getObjectHandle().getOwningQPDF())
+                    journal_incomplete(*q);
+            },
             R"~~~(
                 Removes from the resources dictionary any object not referenced in the content stream.
 
@@ -143,8 +330,13 @@ void init_page(py::module_ &m)
                 objects in files that used shared resource dictionaries across
                 multiple pages.
             )~~~")
-        .def("as_form_xobject",
-            &QPDFPageObjectHelper::getFormXObjectForPage,
+        .def(
+            "as_form_xobject",
+            [](QPDFPageObjectHelper &poh, bool handle_transformations) {
+                auto form = poh.getFormXObjectForPage(handle_transformations);
+                journal_updated(form);
+                return form;
+            },
             py::arg("handle_transformations") = true,
             R"~~~(
                 Return a form XObject that draws this page.
@@ -249,6 +441,10 @@ void init_page(py::module_ &m)
                 auto pytf   = py::cast(tf);
                 py::detail::keep_alive_impl(pyqpdf, pytf);
 
+                // Python filters run while saving; ContentRules never calls Python
+                auto *owner = poh.getObjectHandle().getOwningQPDF();
+                if (owner && !dynamic_cast<ContentRules *>(tf.getPointer()))
+                    get_pdf_state(*owner).calls_python = true;
                 poh.addContentTokenFilter(tf);
             },
             py::keep_alive<1, 2>(),
@@ -297,7 +493,9 @@ void init_page(py::module_ &m)
                 A ``ValueError`` exception is thrown if the page is not attached
                 to a ``Pdf``.
 
-                Requires O(n) search.
+                Lookups use an index of the page list that is maintained as pages
+                are added and removed, so this is a constant time operation in
+                the common case.
 
                 .. versionadded:: 2.2
             )~~~")
@@ -330,9 +528,6 @@ void init_page(py::module_ &m)
                 pages have the same labels. Labels are not guaranteed to
                 be unique.
 
-                Note that this requires a O(n) search over all pages, to look up
-                the page's index.
-
                 .. versionadded:: 2.2
 
                 .. versionchanged:: 2.9
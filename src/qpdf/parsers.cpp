@@ -6,8 +6,10 @@
  * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
  */
 
-#include <sstream>
+#include <cstring>
 #include <locale>
+#include <map>
+#include <sstream>
 
 #include "pikepdf.h"
 #include "parsers.h"
@@ -33,7 +35,8 @@ void PyParserCallbacks::handleEOF()
 }
 
 OperandGrouper::OperandGrouper(const std::string &operators)
-    : parsing_inline_image(false), count(0)
+    : whitelist_has_q(false), parsing_inline_image(false),
+      parsed(std::make_shared<ParsedContentStream>())
 {
     std::istringstream f(operators);
     f.imbue(std::locale::classic());
@@ -41,65 +44,61 @@ OperandGrouper::OperandGrouper(const std::string &operators)
     while (std::getline(f, s, ' ')) {
         this->whitelist.insert(s);
     }
+    this->whitelist_has_q = this->whitelist.count("q") || this->whitelist.count("Q");
+}
+
+bool OperandGrouper::isWhitelisted(const std::string &op) const
+{
+    if (this->whitelist.empty())
+        return true;
+    if (op[0] == 'q' || op[0] == 'Q') {
+        // We have token with multiple stack push/pops
+        return this->whitelist_has_q;
+    }
+    return this->whitelist.count(op) != 0;
 }
 
 void OperandGrouper::handleObject(QPDFObjectHandle obj)
 {
-    this->count++;
-    if (obj.getTypeCode() == QPDFObject::object_type_e::ot_operator) {
-        std::string op = obj.getOperatorValue();
-
-        // If we have a whitelist and this operator is not on the whitelist,
-        // discard it and all the tokens we collected
-        if (!this->whitelist.empty()) {
-            if (op[0] == 'q' || op[0] == 'Q') {
-                // We have token with multiple stack push/pops
-                if (this->whitelist.count("q") == 0 &&
-                    this->whitelist.count("Q") == 0) {
-                    this->tokens.clear();
-                    return;
-                }
-            } else if (this->whitelist.count(op) == 0) {
-                this->tokens.clear();
-                return;
-            }
-        }
-        if (op == "BI") {
-            this->parsing_inline_image = true;
-        } else if (this->parsing_inline_image) {
-            if (op == "ID") {
-                this->inline_metadata = this->tokens;
-            } else if (op == "EI") {
-                auto PdfInlineImage =
-                    py::module_::import("pikepdf").attr("PdfInlineImage");
-                auto kwargs            = py::dict();
-                kwargs["image_data"]   = this->tokens[0];
-                kwargs["image_object"] = this->inline_metadata;
-                auto iimage            = PdfInlineImage(**kwargs);
-
-                // Package as list with single element for consistency
-                auto iimage_list = py::list();
-                iimage_list.append(iimage);
-
-                auto instruction = py::make_tuple(
-                    iimage_list, QPDFObjectHandle::newOperator("INLINE IMAGE"));
-                this->instructions.append(instruction);
-
-                this->parsing_inline_image = false;
-                this->inline_metadata.clear();
+    if (obj.getTypeCode() != QPDFObject::object_type_e::ot_operator) {
+        this->tokens.push_back(obj);
+        return;
+    }
+
+    std::string op = obj.getOperatorValue();
+
+    // If we have a whitelist and this operator is not on the whitelist,
+    // discard it and all the tokens we collected
+    if (!this->isWhitelisted(op)) {
+        this->tokens.clear();
+        return;
+    }
+
+    auto &operands = this->parsed->operands;
+    if (op == "BI") {
+        this->parsing_inline_image = true;
+    } else if (this->parsing_inline_image) {
+        if (op == "ID") {
+            this->inline_metadata = this->tokens;
+        } else if (op == "EI") {
+            if (!this->tokens.empty()) {
+                size_t first = operands.size();
+                operands.insert(operands.end(),
+                    this->inline_metadata.begin(),
+                    this->inline_metadata.end());
+                operands.push_back(this->tokens[0]); // The image data
+                this->parsed->instructions.push_back(
+                    {first, operands.size() - first, obj, true});
             }
-        } else {
-            py::tuple instruction;
-            if (this->tokens.empty())
-                instruction = py::make_tuple(py::tuple(), obj);
-            else
-                instruction = py::make_tuple(this->tokens, obj);
-            this->instructions.append(instruction);
+            this->parsing_inline_image = false;
+            this->inline_metadata.clear();
         }
-        this->tokens.clear();
     } else {
-        this->tokens.push_back(obj);
+        size_t first = operands.size();
+        operands.insert(operands.end(), this->tokens.begin(), this->tokens.end());
+        this->parsed->instructions.push_back({first, this->tokens.size(), obj, false});
     }
+    this->tokens.clear();
 }
 
 void OperandGrouper::handleEOF()
@@ -108,25 +107,179 @@ void OperandGrouper::handleEOF()
         this->warning = "Unexpected end of stream";
 }
 
-py::list OperandGrouper::getInstructions() const { return this->instructions; }
+std::shared_ptr<ParsedContentStream> OperandGrouper::getInstructions() const
+{
+    return this->parsed;
+}
 std::string OperandGrouper::getWarning() const { return this->warning; }
 
-py::bytes unparse_content_stream(py::iterable contentstream)
+py::object ParsedContentStream::instruction(size_t index)
+{
+    if (index >= this->instructions.size())
+        throw py::index_error("instruction index out of range");
+    const auto &instruction = this->instructions[index];
+    auto begin              = this->operands.begin() + instruction.first_operand;
+    auto end                = begin + instruction.operand_count;
+
+    if (instruction.inline_image) {
+        if (!this->PdfInlineImage)
+            this->PdfInlineImage = py::module_::import("pikepdf").attr("PdfInlineImage");
+        auto kwargs            = py::dict();
+        kwargs["image_data"]   = *(end - 1);
+        kwargs["image_object"] = std::vector<QPDFObjectHandle>(begin, end - 1);
+        auto iimage            = this->PdfInlineImage(**kwargs);
+
+        // Package as list with single element for consistency
+        auto iimage_list = py::list();
+        iimage_list.append(iimage);
+        return py::make_tuple(
+            iimage_list, QPDFObjectHandle::newOperator("INLINE IMAGE"));
+    }
+    if (instruction.operand_count == 0)
+        return py::make_tuple(py::tuple(), instruction.op);
+    return py::make_tuple(std::vector<QPDFObjectHandle>(begin, end), instruction.op);
+}
+
+// Writes content stream instructions into one growing buffer. Common operand types
+// are formatted directly instead of through QPDFObjectHandle::unparseBinary().
+class ContentStreamWriter {
+public:
+    explicit ContentStreamWriter(size_t size_hint) { this->out.reserve(size_hint); }
+
+    void writeObject(QPDFObjectHandle &h)
+    {
+        switch (h.getTypeCode()) {
+        case QPDFObject::object_type_e::ot_integer:
+            this->out += std::to_string(h.getIntValue());
+            break;
+        case QPDFObject::object_type_e::ot_real:
+            this->out += h.getRealValue();
+            break;
+        case QPDFObject::object_type_e::ot_name: {
+            auto name = h.getName();
+            if (is_plain_name(name))
+                this->out += name;
+            else
+                this->out += h.unparseBinary();
+            break;
+        }
+        case QPDFObject::object_type_e::ot_operator:
+            this->out += h.getOperatorValue();
+            break;
+        default:
+            this->out += h.unparseBinary();
+        }
+    }
+
+    void writeOperand(py::handle operand)
+    {
+        if (Py_TYPE(operand.ptr()) == &PyLong_Type) {
+            this->out += std::to_string(operand.cast<long long>());
+            return;
+        }
+        QPDFObjectHandle obj = objecthandle_encode(operand);
+        this->writeObject(obj);
+    }
+
+    // Write instruction index of parsed, which Python has never accessed
+    void writeParsed(ParsedContentStream &parsed, size_t index)
+    {
+        const auto &instruction = parsed.instructions.at(index);
+        auto begin = parsed.operands.begin() + instruction.first_operand;
+        auto end   = begin + instruction.operand_count;
+        if (instruction.inline_image) {
+            this->writeInlineImage(begin, end - 1, *(end - 1));
+            return;
+        }
+        for (auto it = begin; it != end; ++it) {
+            this->writeObject(*it);
+            this->out += ' ';
+        }
+        this->out += instruction.op.getOperatorValue();
+    }
+
+    // Write an inline image the way PdfInlineImage.unparse() does, using the
+    // abbreviated names that inline images require
+    void writeInlineImage(std::vector<QPDFObjectHandle>::iterator metadata_begin,
+        std::vector<QPDFObjectHandle>::iterator metadata_end,
+        QPDFObjectHandle image_data)
+    {
+        if (!this->abbreviations_loaded) {
+            auto reverse_abbrevs = py::module_::import("pikepdf")
+                                       .attr("PdfInlineImage")
+                                       .attr("REVERSE_ABBREVS");
+            this->abbreviations =
+                reverse_abbrevs.cast<std::map<std::string, std::string>>();
+            this->abbreviations_loaded = true;
+        }
+
+        this->out += "BI\n";
+        const char *delim = "";
+        for (auto it = metadata_begin; it != metadata_end; ++it) {
+            this->out += delim;
+            delim         = " ";
+            auto unparsed = it->unparseResolved();
+            if (it->isName()) {
+                auto found = this->abbreviations.find(unparsed);
+                if (found != this->abbreviations.end())
+                    unparsed = found->second;
+            }
+            this->out += unparsed;
+        }
+        this->out += "\nID\n";
+        this->out += image_data.getInlineImageValue();
+        this->out += "EI";
+    }
+
+    std::string out;
+
+private:
+    // True if name can be written as is, because it has nothing that
+    // QPDF_Name::normalizeName would escape
+    static bool is_plain_name(const std::string &name)
+    {
+        if (name.empty() || name[0] != '/')
+            return false;
+        for (size_t i = 1; i < name.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(name[i]);
+            if (c < 33 || c > 126 || std::strchr("#()<>[]{}/%", c))
+                return false;
+        }
+        return true;
+    }
+
+    bool abbreviations_loaded = false;
+    std::map<std::string, std::string> abbreviations;
+};
+
+py::bytes unparse_content_stream(
+    py::iterable contentstream, std::shared_ptr<ParsedContentStream> parsed)
 {
     uint n = 0;
-    std::ostringstream ss, errmsg;
+    std::ostringstream errmsg;
     const char *delim = "";
-    ss.imbue(std::locale::classic());
 
-    for (const auto &item : contentstream) {
-        auto operands_op = py::reinterpret_borrow<py::sequence>(item);
+    // Most operands and operators are short, so this is usually close
+    size_t size_hint = parsed ? parsed->operands.size() * 8 + parsed->size() * 4
+                              : py::len_hint(contentstream) * 32;
+    ContentStreamWriter writer(size_hint);
+    auto &ss = writer.out;
 
+    for (const auto &item : contentstream) {
         // First iteration: print nothing
         // All others: print "\n" to delimit previous
         // Result is no leading or trailing delimiter
-        ss << delim;
+        ss += delim;
         delim = "\n";
 
+        // None stands for an instruction of parsed that was never accessed
+        if (item.is_none() && parsed && n < parsed->size()) {
+            writer.writeParsed(*parsed, n);
+            n++;
+            continue;
+        }
+
+        auto operands_op = py::reinterpret_borrow<py::sequence>(item);
         if (operands_op.size() != 2) {
             errmsg << "Wrong number of operands at content stream instruction " << n
                    << "; expected 2";
@@ -162,25 +315,25 @@ py::bytes unparse_content_stream(py::iterable contentstream)
                 throw py::value_error(errmsg.str());
             }
             py::object iimage_unparsed_bytes = iimage.attr("unparse")();
-            ss << std::string(py::bytes(iimage_unparsed_bytes));
+            ss += std::string(py::bytes(iimage_unparsed_bytes));
         } else {
-            try {
-                // First try direct conversion...
-                auto objectlist = operands_op[0].cast<std::vector<QPDFObjectHandle>>();
-                for (QPDFObjectHandle &obj : objectlist) {
-                    ss << obj.unparseBinary() << " ";
+            py::object operands = operands_op[0];
+            if (py::isinstance<ObjectList>(operands)) {
+                // As returned by parse_content_stream; no conversion needed
+                for (auto &obj : operands.cast<ObjectList &>()) {
+                    writer.writeObject(obj);
+                    ss += ' ';
                 }
-            } catch (const py::cast_error &) {
-                auto operands = py::reinterpret_borrow<py::sequence>(operands_op[0]);
+            } else {
                 for (const auto &operand : operands) {
-                    QPDFObjectHandle obj = objecthandle_encode(operand);
-                    ss << obj.unparseBinary() << " ";
+                    writer.writeOperand(operand);
+                    ss += ' ';
                 }
             }
-            ss << op.unparseBinary();
+            ss += op.getOperatorValue();
         }
 
         n++;
     }
-    return py::bytes(ss.str());
-}
\ No newline at end of file
+    return py::bytes(ss);
+}
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <memory>
+#include <unordered_set>
+
 #include "pikepdf.h"
 
 #include <qpdf/QPDFTokenizer.hh>
@@ -23,6 +26,34 @@ public:
     void handleEOF() override;
 };
 
+// One instruction of a ParsedContentStream. Its operands are
+// operands[first_operand, first_operand + operand_count). For an inline image,
+// they are the image's metadata tokens followed by the image data.
+struct ContentStreamInstruction {
+    size_t first_operand;
+    size_t operand_count;
+    QPDFObjectHandle op;
+    bool inline_image;
+};
+
+// A content stream that has been grouped into instructions. Operands of all
+// instructions share one contiguous vector, and Python objects for an instruction
+// are only created when Python asks for that instruction.
+class ParsedContentStream {
+public:
+    size_t size() const { return this->instructions.size(); }
+
+    // Return the instruction as (operands, operator), as parse_content_stream
+    // always has
+    py::object instruction(size_t index);
+
+    std::vector<QPDFObjectHandle> operands;
+    std::vector<ContentStreamInstruction> instructions;
+
+private:
+    py::object PdfInlineImage; // Looked up on first use
+};
+
 // Used for parse_content_stream. Handles each object by grouping into operands
 // and operators. The whole parse stream can be retrived at once.
 class OperandGrouper : public QPDFObjectHandle::ParserCallbacks {
@@ -31,18 +62,23 @@ public:
     void handleObject(QPDFObjectHandle obj) override;
     void handleEOF() override;
 
-    py::list getInstructions() const;
+    std::shared_ptr<ParsedContentStream> getInstructions() const;
     std::string getWarning() const;
 
 private:
-    std::set<std::string> whitelist;
+    bool isWhitelisted(const std::string &op) const;
+
+    std::unordered_set<std::string> whitelist;
+    bool whitelist_has_q;
     std::vector<QPDFObjectHandle> tokens;
     bool parsing_inline_image;
     std::vector<QPDFObjectHandle> inline_metadata;
-    py::list instructions;
-    uint count;
+    std::shared_ptr<ParsedContentStream> parsed;
     std::string warning;
 };
 
-// unparse the list of instructions generated by an OperandGrouper
-py::bytes unparse_content_stream(py::iterable contentstream);
+// unparse the list of instructions generated by an OperandGrouper. If parsed is
+// given, a None in contentstream stands for the instruction of parsed at the same
+// index.
+py::bytes unparse_content_stream(
+    py::iterable contentstream, std::shared_ptr<ParsedContentStream> parsed = nullptr);
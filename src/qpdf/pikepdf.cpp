@@ -30,8 +30,12 @@
 #include "utils.h"
 #include "parsers.h"
 
-uint DECIMAL_PRECISION = 15;
-bool MMAP_DEFAULT      = false;
+uint DECIMAL_PRECISION  = 15;
+bool MMAP_DEFAULT       = false;
+bool MMAP_POPULATE      = false;
+size_t SAVE_BUFFER_SIZE = 1024 * 1024;
+size_t READ_BLOCK_SIZE  = 64 * 1024;
+size_t READ_BLOCK_COUNT = 16;
 
 class TemporaryErrnoChange {
 public:
@@ -91,10 +95,13 @@ PYBIND11_MODULE(_qpdf, m)
     // -- Core objects --
     init_qpdf(m);
     init_pagelist(m);
+    init_objects(m);
     init_object(m);
+    init_object_convert(m);
 
     // -- Support objects (alphabetize order) --
     init_annotation(m);
+    init_batch(m);
     init_embeddedfiles(m);
     init_nametree(m);
     init_page(m);
@@ -137,6 +144,70 @@ PYBIND11_MODULE(_qpdf, m)
             "set_access_default_mmap",
             [](bool mmap) { MMAP_DEFAULT = mmap; },
             "If True, ``pikepdf.open(...access_mode=access_default)`` will use mmap.")
+        .def(
+            "get_mmap_populate",
+            []() { return MMAP_POPULATE; },
+            "Return True if memory mapped files are prefaulted when opened.")
+        .def(
+            "set_mmap_populate",
+            [](bool populate) { MMAP_POPULATE = populate; },
+            R"~~~(
+            If True, prefault the pages of files opened with memory mapping.
+
+            This asks the operating system to read the whole file into memory
+            when it is mapped (``MAP_POPULATE``), which can be faster for files
+            that will be read in full. It only has an effect on Linux when a PDF
+            is opened by path with ``access_mode=AccessMode.mmap``.
+            )~~~")
+        .def(
+            "get_save_buffer_size",
+            []() { return SAVE_BUFFER_SIZE; },
+            "Return the size of the buffer used to coalesce writes when saving.")
+        .def(
+            "set_save_buffer_size",
+            [](size_t size) {
+                if (size == 0)
+                    throw py::value_error("Buffer size must be at least 1 byte");
+                SAVE_BUFFER_SIZE = size;
+            },
+            R"~~~(
+            Set the size of the buffer used to coalesce writes when saving.
+
+            ``Pdf.save()`` collects the output in a buffer of this size and writes
+            it to the output file or stream in large blocks. The default is 1 MiB.
+
+            Args:
+                size: buffer size in bytes
+            )~~~")
+        .def(
+            "get_read_cache_size",
+            []() { return py::make_tuple(READ_BLOCK_SIZE, READ_BLOCK_COUNT); },
+            "Return the block size and block count used when reading from streams.")
+        .def(
+            "set_read_cache_size",
+            [](size_t block_size, size_t block_count) {
+                if (block_size == 0 || block_count == 0)
+                    throw py::value_error(
+                        "Block size and block count must both be at least 1");
+                READ_BLOCK_SIZE  = block_size;
+                READ_BLOCK_COUNT = block_count;
+            },
+            R"~~~(
+            Set the size of the cache used when opening a PDF from a stream.
+
+            When a PDF is opened from a Python file-like object, pikepdf reads it in
+            blocks of *block_size* bytes and keeps the *block_count* most recently
+            used blocks in memory. This reduces the number of calls made to the
+            stream, which matters for streams where each call is expensive, such as
+            network-backed files. The default is 16 blocks of 64 KiB. The setting
+            applies to PDFs opened after it is changed.
+
+            Args:
+                block_size: size of each block in bytes
+                block_count: number of blocks to keep
+            )~~~",
+            py::arg("block_size"),
+            py::arg("block_count"))
         .def(
             "set_flate_compression_level",
             [](int level) {
@@ -152,7 +223,10 @@ PYBIND11_MODULE(_qpdf, m)
             Args:
                 level: -1 (default), 0 (no compression), 1 to 9 (increasing compression)
             )~~~")
-        .def("_unparse_content_stream", unparse_content_stream);
+        .def("_unparse_content_stream",
+            unparse_content_stream,
+            py::arg("contentstream"),
+            py::arg("parsed") = py::none());
 
     // -- Exceptions --
     static py::exception<QPDFExc> exc_main(m, "PdfError");
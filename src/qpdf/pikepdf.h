@@ -9,9 +9,11 @@
 #pragma once
 
 #include <exception>
+#include <functional>
 #include <vector>
 #include <map>
 
+#include <qpdf/Buffer.hh>
 #include <qpdf/PointerHolder.hh>
 #include <qpdf/QPDF.hh>
 #include <qpdf/QPDFObjectHandle.hh>
@@ -251,8 +253,51 @@ PYBIND11_MAKE_OPAQUE(ObjectList);
 using ObjectMap = std::map<std::string, QPDFObjectHandle>;
 PYBIND11_MAKE_OPAQUE(ObjectMap);
 
+// QPDFObjGen only defines operator<, so supply a hash to allow unordered lookup
+struct ObjGenHash {
+    size_t operator()(const QPDFObjGen &og) const
+    {
+        auto key = (static_cast<unsigned long long>(og.getObj()) << 32) |
+                   static_cast<unsigned int>(og.getGen());
+        return std::hash<unsigned long long>()(key);
+    }
+};
+
 // From qpdf.cpp
 void init_qpdf(py::module_ &m);
+void qpdf_basic_settings(QPDF &q);
+void decode_all_streams_and_discard(QPDF &q);
+
+// From batch.cpp
+struct StreamProblem {
+    QPDFObjGen og;
+    QPDFExc error;
+};
+void init_batch(py::module_ &m);
+std::vector<StreamProblem> decode_streams_parallel(QPDF &q, size_t workers);
+// A stream whose data precompress_streams() replaced, and what it had before
+struct ReplacedStream {
+    QPDFObjectHandle stream;
+    QPDFObjectHandle filter;
+    QPDFObjectHandle decode_parms;
+    QPDFObjectHandle length;
+    // For streams whose data pikepdf set, whichever of these it was set from;
+    // neither for streams read from the file
+    PointerHolder<QPDFObjectHandle::StreamDataProvider> provider;
+    PointerHolder<Buffer> raw_data;
+};
+// Flate-compress on several threads the streams that QPDFWriter would compress,
+// and store the compressed data in them until restore_streams() is called with
+// the streams added to replaced. Does not call into Python.
+void precompress_streams(QPDF &q,
+    qpdf_stream_decode_level_e decode_level,
+    bool recompress_flate,
+    size_t workers,
+    std::vector<ReplacedStream> &replaced);
+void restore_streams(std::vector<ReplacedStream> &replaced);
+
+// From qpdf_incremental.cpp
+py::bytes incremental_update(QPDF &q, std::string path, bool deduplicate);
 
 // From object.cpp
 size_t list_range_check(QPDFObjectHandle h, int index);
@@ -264,7 +309,12 @@ std::string objecthandle_pythonic_typename(QPDFObjectHandle h);
 std::string objecthandle_repr_typename_and_value(QPDFObjectHandle h);
 std::string objecthandle_repr(QPDFObjectHandle h);
 
+// From object_digest.cpp
+py::bytes objecthandle_digest(QPDFObjectHandle h, bool decode, bool use_cache);
+size_t deduplicate_objects(QPDF &q);
+
 // From object_convert.cpp
+void init_object_convert(py::module_ &m);
 py::object decimal_from_pdfobject(QPDFObjectHandle h);
 QPDFObjectHandle objecthandle_encode(const py::handle handle);
 std::vector<QPDFObjectHandle> array_builder(const py::iterable iter);
@@ -278,6 +328,10 @@ void init_embeddedfiles(py::module_ &m);
 // From nametree.cpp
 void init_nametree(py::module_ &m);
 
+// From qpdf_objects.cpp
+void init_objects(py::module_ &m);
+py::object object_table(std::shared_ptr<QPDF> q);
+
 // From page.cpp
 void init_page(py::module_ &m);
 size_t page_index(QPDF &owner, QPDFObjectHandle page);
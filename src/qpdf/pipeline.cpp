@@ -6,6 +6,10 @@
  * Copyright (C) 2017, James R. Barlow (https://github.com/jbarlow83/)
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
 #include <qpdf/Constants.h>
 #include <qpdf/Types.h>
 #include <qpdf/DLL.h>
@@ -23,12 +27,60 @@
 #include "pipeline.h"
 #include "utils.h"
 
-void Pl_PythonOutput::write(unsigned char *buf, size_t len)
+/* POSIX functions on Windows have a leading underscore
+ */
+#if defined(_WIN32)
+#    include <io.h>
+#    define posix_write _write
+#    define posix_lseek _lseeki64
+#else
+#    include <unistd.h>
+#    define posix_write ::write
+#    define posix_lseek ::lseek
+#endif
+
+Pl_BufferedOutput::Pl_BufferedOutput(const char *identifier, size_t buffer_size)
+    : Pipeline(identifier, nullptr), buffer(std::max<size_t>(buffer_size, 1))
+{
+}
+
+void Pl_BufferedOutput::write(unsigned char *buf, size_t len)
+{
+    if (this->buffer_used + len > this->buffer.size()) {
+        this->flush_buffer();
+        if (len >= this->buffer.size()) {
+            // Too big to be worth copying
+            this->write_block(buf, len);
+            return;
+        }
+    }
+    std::memcpy(this->buffer.data() + this->buffer_used, buf, len);
+    this->buffer_used += len;
+}
+
+void Pl_BufferedOutput::flush_buffer()
+{
+    if (this->buffer_used == 0)
+        return;
+    // Reset first, so that a failed write is not retried by a later flush
+    auto used         = this->buffer_used;
+    this->buffer_used = 0;
+    this->write_block(this->buffer.data(), used);
+}
+
+void Pl_BufferedOutput::finish()
+{
+    this->flush_buffer();
+    this->flush_output();
+}
+
+void Pl_PythonOutput::write_block(const unsigned char *buf, size_t len)
 {
     py::gil_scoped_acquire gil;
     py::ssize_t so_far = 0;
     while (len > 0) {
-        auto view_buffer  = py::memoryview::from_memory(buf, len);
+        auto view_buffer =
+            py::memoryview::from_memory(const_cast<unsigned char *>(buf), len);
         py::object result = this->stream.attr("write")(view_buffer);
         try {
             so_far = result.cast<py::ssize_t>();
@@ -47,8 +99,40 @@ void Pl_PythonOutput::write(unsigned char *buf, size_t len)
     }
 }
 
-void Pl_PythonOutput::finish()
+void Pl_PythonOutput::flush_output()
 {
     py::gil_scoped_acquire gil;
     this->stream.attr("flush")();
 }
+
+Pl_FileDescriptorOutput::Pl_FileDescriptorOutput(
+    const char *identifier, int fd, qpdf_offset_t offset, size_t buffer_size)
+    : Pl_BufferedOutput(identifier, buffer_size), fd(fd)
+{
+    if (offset >= 0 && posix_lseek(this->fd, offset, SEEK_SET) < 0)
+        QUtil::throw_system_error(this->identifier);
+}
+
+qpdf_offset_t Pl_FileDescriptorOutput::tell()
+{
+    auto pos = posix_lseek(this->fd, 0, SEEK_CUR);
+    if (pos < 0)
+        QUtil::throw_system_error(this->identifier);
+    return pos;
+}
+
+void Pl_FileDescriptorOutput::write_block(const unsigned char *buf, size_t len)
+{
+    while (len > 0) {
+        // Windows can only write up to INT_MAX at a time
+        auto chunk   = std::min<size_t>(len, INT_MAX);
+        auto written = posix_write(this->fd, buf, static_cast<unsigned int>(chunk));
+        if (written <= 0) {
+            if (written < 0 && errno == EINTR)
+                continue;
+            QUtil::throw_system_error(this->identifier);
+        }
+        buf += written;
+        len -= written;
+    }
+}
@@ -10,6 +10,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 #include <qpdf/Constants.h>
 #include <qpdf/Types.h>
@@ -26,22 +27,71 @@
 
 #include "pikepdf.h"
 
-class Pl_PythonOutput : public Pipeline {
-public:
-    Pl_PythonOutput(const char *identifier, py::object stream)
-        : Pipeline(identifier, nullptr), stream(stream)
-    {
-    }
+extern size_t SAVE_BUFFER_SIZE;
 
-    virtual ~Pl_PythonOutput()               = default;
-    Pl_PythonOutput(const Pl_PythonOutput &) = delete;
-    Pl_PythonOutput &operator=(const Pl_PythonOutput &) = delete;
-    Pl_PythonOutput(Pl_PythonOutput &&)                 = delete;
-    Pl_PythonOutput &operator=(Pl_PythonOutput &&) = delete;
+// Coalesces the many small writes made by QPDFWriter into large blocks before
+// passing them to the output.
+class Pl_BufferedOutput : public Pipeline {
+public:
+    Pl_BufferedOutput(const char *identifier, size_t buffer_size);
+    virtual ~Pl_BufferedOutput()                 = default;
+    Pl_BufferedOutput(const Pl_BufferedOutput &) = delete;
+    Pl_BufferedOutput &operator=(const Pl_BufferedOutput &) = delete;
+    Pl_BufferedOutput(Pl_BufferedOutput &&)                 = delete;
+    Pl_BufferedOutput &operator=(Pl_BufferedOutput &&) = delete;
 
     void write(unsigned char *buf, size_t len) override;
     void finish() override;
 
+protected:
+    // Write all of buf to the output
+    virtual void write_block(const unsigned char *buf, size_t len) = 0;
+    // Called after the last block has been written
+    virtual void flush_output() {}
+
+private:
+    void flush_buffer();
+
+    std::vector<unsigned char> buffer;
+    size_t buffer_used = 0;
+};
+
+// Writes to a Python stream, acquiring the GIL only when a block is written.
+class Pl_PythonOutput : public Pl_BufferedOutput {
+public:
+    Pl_PythonOutput(const char *identifier,
+        py::object stream,
+        size_t buffer_size = SAVE_BUFFER_SIZE)
+        : Pl_BufferedOutput(identifier, buffer_size), stream(stream)
+    {
+    }
+    virtual ~Pl_PythonOutput() = default;
+
+protected:
+    void write_block(const unsigned char *buf, size_t len) override;
+    void flush_output() override;
+
 private:
     py::object stream;
 };
+
+// Writes directly to a file descriptor, without calling into Python. It does not
+// need the GIL and does not take ownership of the file descriptor.
+class Pl_FileDescriptorOutput : public Pl_BufferedOutput {
+public:
+    // Writing begins at offset, or the current position if offset is negative
+    Pl_FileDescriptorOutput(const char *identifier,
+        int fd,
+        qpdf_offset_t offset,
+        size_t buffer_size = SAVE_BUFFER_SIZE);
+    virtual ~Pl_FileDescriptorOutput() = default;
+
+    // Position of the file descriptor, which is where writing stopped after finish()
+    qpdf_offset_t tell();
+
+protected:
+    void write_block(const unsigned char *buf, size_t len) override;
+
+private:
+    int fd;
+};
@@ -6,6 +6,7 @@
  * Copyright (C) 2017, James R. Barlow (https://github.com/jbarlow83/)
  */
 
+#include <algorithm>
 #include <sstream>
 #include <type_traits>
 #include <cerrno>
@@ -30,6 +31,7 @@
 #include <pybind11/buffer_info.h>
 
 #include "qpdf_pagelist.h"
+#include "qpdf_state.h"
 #include "qpdf_inputsource-inl.h"
 #include "mmap_inputsource-inl.h"
 #include "pipeline.h"
@@ -55,6 +57,15 @@ void qpdf_basic_settings(QPDF &q)
     q.setImmediateCopyFrom(true);
 }
 
+void decode_all_streams_and_discard(QPDF &q)
+{
+    QPDFWriter w(q);
+    Pl_Discard discard;
+    w.setOutputPipeline(&discard);
+    w.setDecodeLevel(qpdf_dl_all);
+    w.write();
+}
+
 std::shared_ptr<QPDF> open_pdf(py::object filename_or_stream,
     std::string password,
     bool hex_password            = false,
@@ -64,7 +75,7 @@ std::shared_ptr<QPDF> open_pdf(py::object filename_or_stream,
     bool inherit_page_attributes = true,
     access_mode_e access_mode    = access_mode_e::access_default)
 {
-    auto q = std::make_shared<QPDF>();
+    auto q = make_qpdf();
 
     qpdf_basic_settings(*q);
     q->setSuppressWarnings(suppress_warnings);
@@ -73,31 +84,60 @@ std::shared_ptr<QPDF> open_pdf(py::object filename_or_stream,
     q->setAttemptRecovery(attempt_recovery);
 
     py::object stream;
-    bool closing_stream;
+    py::object filename;
+    bool closing_stream = false;
     std::string description;
+    std::string path;
 
     if (py::hasattr(filename_or_stream, "read") &&
         py::hasattr(filename_or_stream, "seek")) {
         // Python code gave us an object with a stream interface
         stream = filename_or_stream;
         check_stream_is_usable(stream);
-        closing_stream = false;
-        description    = py::repr(stream);
+        description = py::repr(stream);
     } else {
         if (py::isinstance<py::int_>(filename_or_stream))
             throw py::type_error("expected str, bytes or os.PathLike object");
-        auto filename  = fspath(filename_or_stream);
-        auto io_open   = py::module_::import("io").attr("open");
-        stream         = io_open(filename, "rb");
-        closing_stream = true;
-        description    = py::str(filename);
+        filename    = fspath(filename_or_stream);
+        description = py::str(filename);
+        path        = py::bytes(py::module_::import("os").attr("fsencode")(filename));
     }
 
     bool success = false;
     if (access_mode == access_default)
         access_mode = MMAP_DEFAULT ? access_mmap : access_stream;
 
-    if (access_mode == access_mmap || access_mode == access_mmap_only) {
+#ifdef PIKEPDF_NATIVE_MMAP
+    if (filename && (access_mode == access_mmap || access_mode == access_mmap_only)) {
+        // Map paths natively so that opening and closing does not need the GIL.
+        py::gil_scoped_release release;
+        std::unique_ptr<PosixMmapInputSource> mmap_input_source;
+        try {
+            mmap_input_source =
+                std::make_unique<PosixMmapInputSource>(path, description);
+        } catch (const QPDFSystemError &) {
+            if (access_mode == access_mmap_only)
+                throw;
+        }
+        if (mmap_input_source) {
+            auto *mapped      = mmap_input_source.get();
+            auto input_source = PointerHolder<InputSource>(mmap_input_source.release());
+            q->processInputSource(input_source, password.c_str());
+            mapped->advise_random();
+            success = true;
+        } else {
+            access_mode = access_stream;
+        }
+    }
+#endif
+
+    if (!success && filename) {
+        auto io_open   = py::module_::import("io").attr("open");
+        stream         = io_open(filename, "rb");
+        closing_stream = true;
+    }
+
+    if (!success && (access_mode == access_mmap || access_mode == access_mmap_only)) {
         try {
             py::gil_scoped_release release;
             auto mmap_input_source =
@@ -120,6 +160,7 @@ std::shared_ptr<QPDF> open_pdf(py::object filename_or_stream,
         py::gil_scoped_release release;
         auto stream_input_source = std::make_unique<PythonStreamInputSource>(
             stream, description, closing_stream);
+        get_pdf_state(*q).read_cache = stream_input_source->get_stats();
         auto input_source = PointerHolder<InputSource>(stream_input_source.release());
         q->processInputSource(input_source, password.c_str());
         success = true;
@@ -132,6 +173,18 @@ std::shared_ptr<QPDF> open_pdf(py::object filename_or_stream,
         // LCOV_EXCL_STOP
     }
 
+    // Remember how to reopen the file, but not a password: it should not outlive
+    // opening, so views of encrypted files are not supported
+    if (filename && !q->isEncrypted()) {
+        auto source                 = std::make_unique<SourceFile>();
+        source->path                = path;
+        source->hex_password        = hex_password;
+        source->ignore_xref_streams = ignore_xref_streams;
+        source->attempt_recovery    = attempt_recovery;
+
+        get_pdf_state(*q).source_file = std::move(source);
+    }
+
     if (inherit_page_attributes) {
         // This could be expensive for a large file, plausibly (not tested),
         // so release the GIL again.
@@ -337,6 +390,28 @@ pdf_version_extension get_version_extension(py::object ver_ext)
     return pdf_version_extension(version, extension);
 }
 
+// If stream is a plain binary file, find the file descriptor and the offset where
+// its next write would land, so that we can write to the file descriptor without
+// going through Python. Other file-like objects may also have a fileno(), but some
+// of those (e.g. gzip.GzipFile) transform what is written, so we don't use it.
+bool get_stream_fd(py::object stream, int &fd, qpdf_offset_t &offset)
+{
+    auto io          = py::module_::import("io");
+    auto stream_type = py::type::of(stream);
+    if (!stream_type.is(io.attr("FileIO")) &&
+        !stream_type.is(io.attr("BufferedWriter")) &&
+        !stream_type.is(io.attr("BufferedRandom")))
+        return false;
+    try {
+        stream.attr("flush")();
+        fd     = stream.attr("fileno")().cast<int>();
+        offset = stream.attr("tell")().cast<qpdf_offset_t>();
+    } catch (const py::error_already_set &) {
+        return false;
+    }
+    return true;
+}
+
 void save_pdf(QPDF &q,
     py::object filename_or_stream,
     bool static_id                          = false,
@@ -353,8 +428,14 @@ void save_pdf(QPDF &q,
     py::object progress                     = py::none(),
     py::object encryption                   = py::none(),
     bool samefile_check                     = true,
-    bool recompress_flate                   = false)
+    bool recompress_flate                   = false,
+    py::object workers                      = py::none(),
+    bool deduplicate                        = false)
 {
+    // Other threads may run if we write without the GIL; make sure none of them
+    // saves or closes this PDF at the same time
+    PdfSaveLock save_lock(q);
+
     std::string description;
     QPDFWriter w(q);
 
@@ -419,8 +500,18 @@ void save_pdf(QPDF &q,
     }
 
     // We must set up the output pipeline before we configure encryption
-    Pl_PythonOutput output_pipe(description.c_str(), stream);
-    w.setOutputPipeline(&output_pipe);
+    std::unique_ptr<Pl_FileDescriptorOutput> fd_pipe;
+    std::unique_ptr<Pl_PythonOutput> python_pipe;
+    int fd               = -1;
+    qpdf_offset_t offset = 0;
+    if (get_stream_fd(stream, fd, offset)) {
+        fd_pipe =
+            std::make_unique<Pl_FileDescriptorOutput>(description.c_str(), fd, offset);
+        w.setOutputPipeline(fd_pipe.get());
+    } else {
+        python_pipe = std::make_unique<Pl_PythonOutput>(description.c_str(), stream);
+        w.setOutputPipeline(python_pipe.get());
+    }
 
     if (encryption.is(py::bool_(true)) && !q.isEncrypted()) {
         throw py::value_error(
@@ -444,6 +535,26 @@ void save_pdf(QPDF &q,
     if (normalize_content && linearize) {
         throw py::value_error("cannot save with both normalize_content and linearize");
     }
+    // Compress streams on worker threads before writing, and have QPDFWriter
+    // write every stream that already has a filter as it is. QPDFWriter still
+    // compresses the object and cross-reference streams it creates.
+    size_t precompress_workers = 0;
+    auto precompress_level     = qpdf_dl_generalized;
+    if (!workers.is_none() && compress_streams) {
+        auto n = workers.cast<long long>();
+        if (n < 1)
+            throw py::value_error("workers must be at least 1");
+        if (!encryption.is_none() && !encryption.is(py::bool_(false)))
+            throw py::value_error("cannot save with both workers and encryption");
+        if (normalize_content || qdf)
+            throw py::value_error(
+                "cannot save with workers and normalize_content or qdf");
+        if (!stream_decode_level.is_none())
+            precompress_level = stream_decode_level.cast<qpdf_stream_decode_level_e>();
+        precompress_workers = static_cast<size_t>(n);
+        w.setDecodeLevel(qpdf_dl_none);
+    }
+
     w.setContentNormalization(normalize_content);
     w.setLinearization(linearize);
     w.setQDFMode(qdf);
@@ -452,6 +563,10 @@ void save_pdf(QPDF &q,
         auto version_ext = get_version_extension(force_version);
         w.forcePDFVersion(version_ext.first, version_ext.second);
     }
+    // Only once every option has been checked, so that a save that is going to
+    // fail does not change the PDF first
+    if (deduplicate)
+        deduplicate_objects(q);
     if (fix_metadata_version) {
         update_xmp_pdfversion(q, w.getFinalVersion());
     }
@@ -462,7 +577,29 @@ void save_pdf(QPDF &q,
         w.registerProgressReporter(reporter);
     }
 
-    w.write();
+    // Keep the GIL for the whole write, even to a file descriptor. Another thread
+    // that ran part way through would share QPDF's object cache and input file
+    // position with QPDFWriter, so even reading this PDF would race with it.
+    // Precompressed data is only lent to QPDFWriter: the streams get their own
+    // data back once the file is written, or if writing fails.
+    std::vector<ReplacedStream> replaced;
+    try {
+        if (precompress_workers)
+            precompress_streams(q,
+                precompress_level,
+                recompress_flate,
+                precompress_workers,
+                replaced);
+        w.write();
+    } catch (...) {
+        restore_streams(replaced);
+        throw;
+    }
+    restore_streams(replaced);
+    if (fd_pipe) {
+        // We wrote behind the Python file object's back, so bring it up to date
+        stream.attr("seek")(fd_pipe->tell());
+    }
 }
 
 void init_qpdf(py::module_ &m)
@@ -496,7 +633,7 @@ void init_qpdf(py::module_ &m)
         .def_static(
             "new",
             []() {
-                auto q = std::make_shared<QPDF>();
+                auto q = make_qpdf();
                 q->emptyPDF();
                 qpdf_basic_settings(*q);
                 return q;
@@ -606,6 +743,14 @@ void init_qpdf(py::module_ &m)
             "_add_page",
             [](QPDF &q, QPDFObjectHandle &page, bool first = false) {
                 q.addPage(page, first);
+                note_copied_from(q, page.getOwningQPDF());
+                auto &page_index = get_pdf_state(q).page_index;
+                if (first)
+                    page_index.invalidate();
+                else
+                    page_index.page_inserted(q, q.getAllPages().size() - 1);
+                journal_updated(first ? q.getAllPages().front() : q.getAllPages().back());
+                journal_pages_changed(q);
             },
             R"~~~(
             Attach a page to this PDF.
@@ -620,13 +765,35 @@ void init_qpdf(py::module_ &m)
             py::arg("page"),
             py::arg("first") = false,
             py::keep_alive<1, 2>())
-        .def("_add_page_at", &QPDF::addPageAt, py::keep_alive<1, 2>())
-        .def("_remove_page", &QPDF::removePage)
+        .def(
+            "_add_page_at",
+            [](QPDF &q, QPDFObjectHandle &page, bool before, QPDFObjectHandle &refpage) {
+                q.addPageAt(page, before, refpage);
+                note_copied_from(q, page.getOwningQPDF());
+                get_pdf_state(q).page_index.invalidate();
+                auto &pages = q.getAllPages();
+                auto at     = std::find_if(pages.begin(),
+                    pages.end(),
+                    [&refpage](QPDFObjectHandle &p) {
+                        return p.getObjGen() == refpage.getObjGen();
+                    });
+                if (at != pages.end())
+                    journal_updated(before ? *(at - 1) : *(at + 1));
+                journal_pages_changed(q);
+            },
+            py::keep_alive<1, 2>())
+        .def("_remove_page",
+            [](QPDF &q, QPDFObjectHandle &page) {
+                q.removePage(page);
+                get_pdf_state(q).page_index.invalidate();
+                journal_pages_changed(q);
+            })
         .def(
             "remove_unreferenced_resources",
             [](QPDF &q) {
                 QPDFPageDocumentHelper helper(q);
                 helper.removeUnreferencedResources();
+                journal_incomplete(q);
             },
             R"~~~(
             Remove from /Resources of each page any object not referenced in page's contents
@@ -664,7 +831,52 @@ void init_qpdf(py::module_ &m)
             py::arg("progress")             = py::none(),
             py::arg("encryption")           = py::none(),
             py::arg("samefile_check")       = true,
-            py::arg("recompress_flate")     = false)
+            py::arg("recompress_flate")     = false,
+            py::arg("workers")              = py::none(),
+            py::arg("deduplicate")          = false)
+        .def("_incremental_update",
+            incremental_update,
+            R"~~~(
+            Return an incremental update that brings the file at *path* up to date
+            with this Pdf, or empty bytes if nothing changed.
+
+            The file must be the one this Pdf was opened from, possibly with
+            incremental updates appended since. If *deduplicate* is true,
+            :meth:`deduplicate` is called once the Pdf is known to be suitable.
+            )~~~",
+            py::arg("path"),
+            py::kw_only(),
+            py::arg("deduplicate") = false)
+        .def(
+            "_merge",
+            [](QPDF &q,
+                py::iterable sources,
+                size_t workers,
+                std::string password,
+                bool hex_password,
+                bool attempt_recovery) {
+                std::vector<MergeSource> merge;
+                for (auto item : sources) {
+                    MergeSource source;
+                    if (py::isinstance<QPDF>(item))
+                        source.pdf = item.cast<std::shared_ptr<QPDF>>();
+                    else
+                        source.path = item.cast<std::string>();
+                    merge.push_back(std::move(source));
+                }
+
+                SourceFile how_to_open;
+                how_to_open.password         = password;
+                how_to_open.hex_password     = hex_password;
+                how_to_open.attempt_recovery = attempt_recovery;
+                return merge_sources(q, merge, workers, how_to_open);
+            },
+            "Used to implement Pdf.merge().",
+            py::arg("sources"),
+            py::arg("workers"),
+            py::arg("password")         = "",
+            py::arg("hex_password")     = false,
+            py::arg("attempt_recovery") = true)
         .def("_get_object_id", &QPDF::getObjectByID)
         .def(
             "get_object",
@@ -693,19 +905,42 @@ void init_qpdf(py::module_ &m)
             py::arg("gen"))
         .def_property_readonly(
             "objects",
-            [](QPDF &q) { return q.getAllObjects(); },
+            [](std::shared_ptr<QPDF> q) { return object_table(q); },
             R"~~~(
-            Return an iterable list of all objects in the PDF.
+            Return a list-like view of all objects in the PDF.
 
             After deleting content from a PDF such as pages, objects related
             to that page, such as images on the page, may still be present.
 
-            Retun type:
-                pikepdf._qpdf._ObjectList
+            The view is built from the PDF's cross-reference table, and each
+            object is read from the file only when it is accessed, so iterating
+            over the objects of a large PDF can stop early cheaply. Objects
+            created since the PDF was opened are listed after the objects in the
+            file. Use ``pdf.objects.of_type(ObjectType.stream)`` to find all
+            objects of one type.
+
+            .. note::
+
+                ``len(pdf.objects)``, negative indexes and slices, and iterating
+                past the objects in the file, need the objects created since
+                opening. The only way QPDF can find those is to read every object
+                in the file, once per ``Pdf``. ``repr(pdf.objects)`` does not
+                count them.
+
+            Return type:
+                pikepdf._qpdf._ObjectTable
+
+            .. versionchanged:: 3.0
+                Returns a lazy view instead of a list of every object.
             )~~~",
             py::return_value_policy::reference_internal)
-        .def("make_indirect",
-            &QPDF::makeIndirectObject,
+        .def(
+            "make_indirect",
+            [](QPDF &q, QPDFObjectHandle &h) -> QPDFObjectHandle {
+                auto result = q.makeIndirectObject(h);
+                journal_created(result);
+                return result;
+            },
             R"~~~(
             Attach an object to the Pdf as an indirect object
 
@@ -730,7 +965,9 @@ void init_qpdf(py::module_ &m)
         .def(
             "make_indirect",
             [](QPDF &q, py::object obj) -> QPDFObjectHandle {
-                return q.makeIndirectObject(objecthandle_encode(obj));
+                auto result = q.makeIndirectObject(objecthandle_encode(obj));
+                journal_created(result);
+                return result;
             },
             R"~~~(
             Encode a Python object and attach to this Pdf as an indirect object.
@@ -742,7 +979,10 @@ void init_qpdf(py::module_ &m)
         .def(
             "copy_foreign",
             [](QPDF &q, QPDFObjectHandle &h) -> QPDFObjectHandle {
-                return q.copyForeignObject(h);
+                auto copy = q.copyForeignObject(h);
+                note_copied_from(q, h.getOwningQPDF());
+                journal_updated(copy);
+                return copy;
             },
             R"~~~(
             Copy an ``Object`` from a foreign ``Pdf`` to this one.
@@ -774,30 +1014,160 @@ void init_qpdf(py::module_ &m)
             py::arg("h"))
         .def("copy_foreign",
             [](QPDF &q, QPDFPageObjectHelper &poh) -> QPDFPageObjectHelper {
-                return QPDFPageObjectHelper(q.copyForeignObject(poh.getObjectHandle()));
+                auto copy = q.copyForeignObject(poh.getObjectHandle());
+                note_copied_from(q, poh.getObjectHandle().getOwningQPDF());
+                journal_updated(copy);
+                return QPDFPageObjectHelper(copy);
             })
         .def("_replace_object",
             [](QPDF &q, std::pair<int, int> objgen, QPDFObjectHandle &h) {
                 q.replaceObject(objgen.first, objgen.second, h);
+                journal_replaced(q, QPDFObjGen(objgen.first, objgen.second), h);
             })
         .def("_swap_objects",
             [](QPDF &q, std::pair<int, int> objgen1, std::pair<int, int> objgen2) {
                 QPDFObjGen o1(objgen1.first, objgen1.second);
                 QPDFObjGen o2(objgen2.first, objgen2.second);
                 q.swapObjects(o1, o2);
+                journal_modified(q.getObjectByObjGen(o1));
+                journal_modified(q.getObjectByObjGen(o2));
             })
         .def(
             "_close",
-            [](QPDF &q) { q.closeInputSource(); },
+            [](QPDF &q) {
+                PdfSaveLock save_lock(q);
+                q.closeInputSource();
+            },
             "Used to implement Pdf.close().")
-        .def("_decode_all_streams_and_discard",
+        .def("_decode_all_streams_and_discard", &decode_all_streams_and_discard)
+        .def(
+            "_decode_streams_parallel",
+            [](QPDF &q, size_t workers) {
+                py::list result;
+                for (auto &problem : decode_streams_parallel(q, workers)) {
+                    auto objgen =
+                        py::make_tuple(problem.og.getObj(), problem.og.getGen());
+                    result.append(
+                        py::make_tuple(objgen, std::string(problem.error.what())));
+                }
+                return result;
+            },
+            R"~~~(
+            Decode every stream on several threads, discarding the data.
+
+            Each thread opens its own read-only view of the file the Pdf was opened
+            from, so this checks the file as it is on disk and ignores changes made
+            since it was opened. Not available for encrypted files, since the
+            password is not kept after opening.
+
+            Problems are also recorded as warnings on this Pdf.
+
+            Returns:
+                A list of ``((objid, gen), message)`` for each problem found, in
+                object order. Problems that do not belong to an object have
+                ``(0, 0)``.
+            )~~~",
+            py::arg("workers"))
+        .def(
+            "clear_digest_cache",
             [](QPDF &q) {
-                QPDFWriter w(q);
-                Pl_Discard discard;
-                w.setOutputPipeline(&discard);
-                w.setDecodeLevel(qpdf_dl_all);
-                w.write();
-            })
+                auto &state = get_pdf_state(q);
+                state.raw_digests.clear();
+                state.decoded_digests.clear();
+            },
+            R"~~~(
+            Forget the digests remembered by ``Object.content_digest(cache=True)``.
+
+            Call this after modifying objects whose digests were cached.
+
+            .. versionadded:: 3.0
+            )~~~")
+        .def("deduplicate",
+            &deduplicate_objects,
+            R"~~~(
+            Collapse identical page resources into one shared object.
+
+            Fonts, images, color spaces and other indirect objects reachable from
+            the ``/Resources`` of pages are compared by
+            :meth:`Object.content_digest`, without decoding streams. For each
+            group of identical objects, every reference in the PDF is pointed at
+            the one with the lowest object number, and the others are left out
+            when the PDF is saved. This is most useful after merging PDFs made by
+            the same software, which otherwise contain a copy of the same
+            resources for each source.
+
+            Returns:
+                int: The approximate number of bytes saved, counting the
+                serialized size of each duplicate that was removed, before any
+                compression of object streams.
+
+            .. versionadded:: 3.0
+            )~~~")
+        .def(
+            "get_changes",
+            [](QPDF &q) {
+                auto objgens = [](const std::set<QPDFObjGen> &ogs) {
+                    py::list result;
+                    for (auto &og : ogs)
+                        result.append(py::make_tuple(og.getObj(), og.getGen()));
+                    return result;
+                };
+                journal_update_watched(q);
+                auto &journal = get_pdf_state(q).journal;
+                return py::dict(py::arg("created") = objgens(journal.created),
+                    py::arg("modified")            = objgens(journal.modified),
+                    py::arg("deleted")             = objgens(journal.deleted),
+                    py::arg("incomplete")          = journal.incomplete);
+            },
+            R"~~~(
+            Return the indirect objects changed since the Pdf was opened or since
+            the last :meth:`checkpoint`.
+
+            Objects are recorded as they are changed through pikepdf: created
+            with :meth:`make_indirect`, ``pikepdf.Stream()`` or
+            :meth:`copy_foreign`, or along with pages added to :attr:`pages`;
+            modified by setting or deleting keys or array items, writing stream
+            data, replacing the stream dictionary or rearranging pages; and
+            deleted by replacing them with null. A change to a direct object that
+            is nested inside another object, such as ``page.MediaBox[2] = 500``,
+            is recorded as a change to the indirect object that contains it,
+            which is found by comparing that object with how it was when the
+            direct object was handed out.
+
+            Some operations are carried out by qpdf in ways that are not followed
+            in detail, for example :meth:`flatten_annotations`,
+            :meth:`remove_unreferenced_resources` and changes to name trees and
+            attachments. After any of these, ``incomplete`` is ``True`` until the
+            next :meth:`checkpoint`.
+
+            Returns:
+                A dict with the keys ``created``, ``modified`` and ``deleted``,
+                each a sorted list of ``(objid, gen)``, and ``incomplete``, a
+                bool. An object appears in at most one of the lists.
+
+            .. versionadded:: 3.0
+            )~~~")
+        .def(
+            "is_changed",
+            [](QPDF &q, std::pair<int, int> objgen) {
+                QPDFObjGen og(objgen.first, objgen.second);
+                journal_update_watched(q);
+                auto &journal = get_pdf_state(q).journal;
+                return journal.created.count(og) || journal.modified.count(og) ||
+                       journal.deleted.count(og);
+            },
+            R"~~~(
+            Return whether the object ``(objid, gen)`` appears in :meth:`get_changes`.
+            )~~~",
+            py::arg("objgen"))
+        .def(
+            "checkpoint",
+            [](QPDF &q) { journal_checkpoint(q); },
+            R"~~~(
+            Forget the changes recorded so far; see :meth:`get_changes`.
+            )~~~")
+        .def_property_readonly("_has_source_file",
+            [](QPDF &q) { return get_pdf_state(q).source_file != nullptr; })
         .def_property_readonly(
             "_allow_accessibility", [](QPDF &q) { return q.allowAccessibility(); })
         .def_property_readonly(
@@ -839,6 +1209,17 @@ void init_qpdf(py::module_ &m)
                     py::arg("user_passwd")    = py::bytes(user_passwd),
                     py::arg("encryption_key") = py::bytes(encryption_key));
             })
+        .def_property_readonly("_read_cache_info",
+            [](QPDF &q) -> py::object {
+                auto stats = get_pdf_state(q).read_cache;
+                if (!stats)
+                    return py::none();
+                return py::dict(py::arg("block_size") = stats->block_size,
+                    py::arg("block_count")             = stats->block_count,
+                    py::arg("hits")                    = stats->hits,
+                    py::arg("misses")                  = stats->misses,
+                    py::arg("stream_reads")            = stats->stream_reads);
+            })
         .def_property_readonly("user_password_matched",
             &QPDF::userPasswordMatched,
             R"~~~(
@@ -862,6 +1243,7 @@ void init_qpdf(py::module_ &m)
             [](QPDF &q) {
                 QPDFAcroFormDocumentHelper afdh(q);
                 afdh.generateAppearancesIfNeeded();
+                journal_incomplete(q);
             },
             R"~~~(
             Generates appearance streams for AcroForm forms and form fields.
@@ -904,6 +1286,7 @@ void init_qpdf(py::module_ &m)
                 }
 
                 dh.flattenAnnotations(required, forbidden);
+                journal_incomplete(q);
             },
             R"~~~(
             Flattens all PDF annotations into regular PDF content.
@@ -0,0 +1,289 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+/*
+ * Incremental updates
+ *
+ * An incremental update is appended to an unchanged PDF. It contains the objects
+ * that differ from the file, a cross-reference section for them and a trailer
+ * whose /Prev points at the file's last cross-reference section. PDF readers use
+ * the newest definition of each object.
+ *
+ * Objects are compared with a second, unmodified QPDF opened from the same file.
+ * The change journal cannot be used to find them instead: it only sees changes
+ * to nested direct objects that were reached through pikepdf, and qpdf's helpers
+ * modify objects without telling pikepdf in detail, which the journal can only
+ * flag as incomplete. So every object is parsed twice, and the time taken grows
+ * with the number of objects in the file, but stream data is not read unless the
+ * stream itself changed.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFExc.hh>
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/QPDFXRefEntry.hh>
+
+#include <pybind11/pybind11.h>
+
+#include "pikepdf.h"
+#include "qpdf_state.h"
+
+// Where the last cross-reference section of a file is, and what kind it is
+struct FileTail {
+    qpdf_offset_t size      = 0;
+    qpdf_offset_t startxref = 0;
+    bool xref_stream        = false;
+    bool ends_with_eol      = false;
+};
+
+static FileTail read_file_tail(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw QPDFExc(qpdf_e_system, path, "", 0, "can't open file for reading");
+
+    FileTail tail;
+    file.seekg(0, std::ios::end);
+    tail.size = static_cast<qpdf_offset_t>(file.tellg());
+
+    auto window = std::min<qpdf_offset_t>(tail.size, 1024);
+    std::string buffer(static_cast<size_t>(window), '\0');
+    file.seekg(tail.size - window);
+    file.read(&buffer[0], window);
+
+    auto found = buffer.rfind("startxref");
+    if (found != std::string::npos)
+        tail.startxref = std::strtoll(buffer.c_str() + found + 9, nullptr, 10);
+    if (found == std::string::npos || tail.startxref <= 0 ||
+        tail.startxref >= tail.size)
+        throw QPDFExc(qpdf_e_damaged_pdf,
+            path,
+            "",
+            tail.size,
+            "can't find startxref; save without incremental to repair the file");
+    tail.ends_with_eol =
+        !buffer.empty() && (buffer.back() == '\n' || buffer.back() == '\r');
+
+    char keyword[4] = {};
+    file.seekg(tail.startxref);
+    file.read(keyword, sizeof(keyword));
+    tail.xref_stream = std::string(keyword, sizeof(keyword)) != "xref";
+    return tail;
+}
+
+static bool same_object(QPDFObjectHandle current, QPDFObjectHandle original)
+{
+    if (current.getTypeCode() != original.getTypeCode())
+        return false;
+    if (current.isStream())
+        return !current.isDataModified() &&
+               current.getDict().unparse() == original.getDict().unparse();
+    return current.unparseResolved() == original.unparseResolved();
+}
+
+static void write_object(std::string &out, QPDFObjectHandle h)
+{
+    auto og = h.getObjGen();
+    out += std::to_string(og.getObj()) + " " + std::to_string(og.getGen()) + " obj\n";
+    if (h.isStream()) {
+        auto data = h.getRawStreamData();
+        auto dict = h.getDict().shallowCopy();
+        dict.replaceKey("/Length",
+            QPDFObjectHandle::newInteger(static_cast<long long>(data->getSize())));
+        out += dict.unparse();
+        out += "\nstream\n";
+        out.append(reinterpret_cast<const char *>(data->getBuffer()), data->getSize());
+        out += "\nendstream\n";
+    } else {
+        out += h.unparseResolved();
+        out += "\n";
+    }
+    out += "endobj\n";
+}
+
+// Consecutive runs of object numbers, as (first, count), for /Index and for the
+// subsections of a cross-reference table
+static std::vector<std::pair<int, int>> subsections(const std::vector<QPDFObjGen> &ogs)
+{
+    std::vector<std::pair<int, int>> runs;
+    for (auto &og : ogs) {
+        if (!runs.empty() && runs.back().first + runs.back().second == og.getObj())
+            ++runs.back().second;
+        else
+            runs.emplace_back(og.getObj(), 1);
+    }
+    return runs;
+}
+
+// The trailer of the update: the current trailer without the keys that describe
+// the previous cross-reference section
+static QPDFObjectHandle update_trailer(QPDF &q, int size, qpdf_offset_t prev)
+{
+    auto trailer = q.getTrailer().shallowCopy();
+    for (auto key : {"/Prev",
+             "/XRefStm",
+             "/Type",
+             "/W",
+             "/Index",
+             "/Length",
+             "/Filter",
+             "/DecodeParms"})
+        trailer.removeKey(key);
+    trailer.replaceKey("/Size", QPDFObjectHandle::newInteger(size));
+    trailer.replaceKey("/Prev", QPDFObjectHandle::newInteger(prev));
+    return trailer;
+}
+
+static void write_xref_table(std::string &out,
+    QPDF &q,
+    const std::vector<QPDFObjGen> &ogs,
+    const std::vector<qpdf_offset_t> &offsets,
+    int size,
+    const FileTail &tail)
+{
+    auto xref_offset = tail.size + static_cast<qpdf_offset_t>(out.size());
+    out += "xref\n";
+    size_t index = 0;
+    for (auto &run : subsections(ogs)) {
+        out += std::to_string(run.first) + " " + std::to_string(run.second) + "\n";
+        for (int n = 0; n < run.second; ++n, ++index) {
+            char entry[21];
+            std::snprintf(entry,
+                sizeof(entry),
+                "%010lld %05d n\r\n",
+                static_cast<long long>(offsets[index]),
+                ogs[index].getGen());
+            out += entry;
+        }
+    }
+    out += "trailer\n";
+    out += update_trailer(q, size, tail.startxref).unparse();
+    out += "\nstartxref\n" + std::to_string(xref_offset) + "\n%%EOF\n";
+}
+
+static void write_xref_stream(std::string &out,
+    QPDF &q,
+    std::vector<QPDFObjGen> ogs,
+    std::vector<qpdf_offset_t> offsets,
+    int size,
+    const FileTail &tail)
+{
+    // The cross-reference stream is an object too, and lists itself
+    auto xref_offset = tail.size + static_cast<qpdf_offset_t>(out.size());
+    ogs.emplace_back(size, 0);
+    offsets.push_back(xref_offset);
+
+    int offset_width = xref_offset > 0xffffffffLL ? 8 : 4;
+    std::string data;
+    for (size_t index = 0; index < ogs.size(); ++index) {
+        data += '\x01';
+        for (int shift = 8 * (offset_width - 1); shift >= 0; shift -= 8)
+            data += static_cast<char>((offsets[index] >> shift) & 0xff);
+        data += static_cast<char>((ogs[index].getGen() >> 8) & 0xff);
+        data += static_cast<char>(ogs[index].getGen() & 0xff);
+    }
+
+    auto index = QPDFObjectHandle::newArray();
+    for (auto &run : subsections(ogs)) {
+        index.appendItem(QPDFObjectHandle::newInteger(run.first));
+        index.appendItem(QPDFObjectHandle::newInteger(run.second));
+    }
+    auto dict = update_trailer(q, size + 1, tail.startxref);
+    dict.replaceKey("/Type", QPDFObjectHandle::newName("/XRef"));
+    dict.replaceKey("/W",
+        QPDFObjectHandle::newArray(std::vector<QPDFObjectHandle>{
+            QPDFObjectHandle::newInteger(1),
+            QPDFObjectHandle::newInteger(offset_width),
+            QPDFObjectHandle::newInteger(2)}));
+    dict.replaceKey("/Index", index);
+    dict.replaceKey("/Length",
+        QPDFObjectHandle::newInteger(static_cast<long long>(data.size())));
+
+    out += std::to_string(size) + " 0 obj\n";
+    out += dict.unparse();
+    out += "\nstream\n" + data + "\nendstream\nendobj\n";
+    out += "startxref\n" + std::to_string(xref_offset) + "\n%%EOF\n";
+}
+
+py::bytes incremental_update(QPDF &q, std::string path, bool deduplicate)
+{
+    if (q.isEncrypted())
+        throw py::value_error("incremental saves of encrypted PDFs are not supported");
+    if (deduplicate)
+        deduplicate_objects(q);
+
+    SourceFile source;
+    auto *opened_from = get_pdf_state(q).source_file.get();
+    if (opened_from)
+        source = *opened_from;
+    source.path = path;
+
+    // Another thread must not save or close q while it is being read
+    PdfSaveLock save_lock(q);
+    std::string out;
+    auto find_changes = [&] {
+        auto tail = read_file_tail(source.path);
+        auto original = open_source_file(source, true);
+        // pikepdf pushes inherited page attributes down to pages when opening,
+        // which is not a change to the document
+        original->pushInheritedAttributesToPage();
+        auto original_xref = original->getXRefTable();
+
+        std::vector<QPDFObjectHandle> changed;
+        auto original_size = original->getTrailer().getKey("/Size");
+        int size           = original_size.isInteger()
+                                 ? static_cast<int>(original_size.getIntValue())
+                                 : 0;
+        for (auto &obj : q.getAllObjects()) {
+            auto og = obj.getObjGen();
+            size    = std::max(size, og.getObj() + 1);
+            if (original_xref.count(og) &&
+                same_object(obj, original->getObjectByObjGen(og)))
+                continue;
+            changed.push_back(obj);
+        }
+        std::sort(changed.begin(),
+            changed.end(),
+            [](QPDFObjectHandle a, QPDFObjectHandle b) {
+                return a.getObjGen() < b.getObjGen();
+            });
+
+        if (!changed.empty()) {
+            if (!tail.ends_with_eol)
+                out += "\n";
+            std::vector<QPDFObjGen> ogs;
+            std::vector<qpdf_offset_t> offsets;
+            for (auto &obj : changed) {
+                ogs.push_back(obj.getObjGen());
+                offsets.push_back(tail.size + static_cast<qpdf_offset_t>(out.size()));
+                write_object(out, obj);
+            }
+
+            if (tail.xref_stream)
+                write_xref_stream(out, q, ogs, offsets, size, tail);
+            else
+                write_xref_table(out, q, ogs, offsets, size, tail);
+        }
+    };
+    // As in save_pdf(), the GIL is kept if reading q may call into Python
+    if (pdf_calls_python(q)) {
+        find_changes();
+    } else {
+        py::gil_scoped_release release;
+        find_changes();
+    }
+    // Empty if nothing changed
+    return py::bytes(out);
+}
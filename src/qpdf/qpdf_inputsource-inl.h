@@ -8,6 +8,9 @@
 
 #include <cstdio>
 #include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 #include <qpdf/Constants.h>
 #include <qpdf/Types.h>
@@ -23,18 +26,33 @@
 #include <pybind11/stl.h>
 
 #include "pikepdf.h"
+#include "qpdf_state.h"
 #include "utils.h"
 
+extern size_t READ_BLOCK_SIZE;
+extern size_t READ_BLOCK_COUNT;
+
+// Reads from a Python stream through a small LRU cache of fixed size blocks.
+// Blocks start at multiples of the block size. qpdf's tokenizer reads one
+// character at a time, and every call into Python needs the GIL, so we keep our
+// own file position and only touch the stream when a block must be fetched.
+// Like the rest of pikepdf, this assumes the stream's data does not change while
+// it is open.
 class PythonStreamInputSource : public InputSource {
 public:
     PythonStreamInputSource(py::object stream, std::string name, bool close)
-        : stream(stream), name(name), close(close)
+        : stream(stream), name(name), close(close), block_size(READ_BLOCK_SIZE),
+          block_count(READ_BLOCK_COUNT),
+          stats(std::make_shared<ReadCacheStats>())
     {
         py::gil_scoped_acquire gil;
         if (!stream.attr("readable")().cast<bool>())
             throw py::value_error("not readable");
         if (!stream.attr("seekable")().cast<bool>())
             throw py::value_error("not seekable");
+        this->pos                = py::cast<qpdf_offset_t>(stream.attr("tell")());
+        this->stats->block_size  = this->block_size;
+        this->stats->block_count = this->block_count;
     }
     virtual ~PythonStreamInputSource()
     {
@@ -56,16 +74,25 @@ public:
 
     std::string const &getName() const override { return this->name; }
 
-    qpdf_offset_t tell() override
-    {
-        py::gil_scoped_acquire gil;
-        return py::cast<qpdf_offset_t>(this->stream.attr("tell")());
-    }
+    qpdf_offset_t tell() override { return this->pos; }
 
     void seek(qpdf_offset_t offset, int whence) override
     {
-        py::gil_scoped_acquire gil;
-        this->stream.attr("seek")(offset, whence);
+        switch (whence) {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += this->pos;
+            break;
+        case SEEK_END:
+            offset += this->size();
+            break;
+        default:
+            throw std::logic_error("PythonStreamInputSource::seek: invalid whence");
+        }
+        if (offset < 0)
+            throw std::runtime_error(this->name + ": seek before beginning of file");
+        this->pos = offset;
     }
 
     // LCOV_EXCL_START
@@ -78,43 +105,48 @@ public:
 
     size_t read(char *buffer, size_t length) override
     {
-        py::gil_scoped_acquire gil;
+        this->last_offset = this->pos;
+
+        size_t bytes_read = 0;
+        if (length >= this->block_size) {
+            // Large reads are usually stream data; don't let them evict the
+            // blocks the tokenizer is working on.
+            bytes_read = this->read_stream(this->pos, buffer, length);
+            this->pos += bytes_read;
+        } else {
+            while (bytes_read < length) {
+                auto index    = static_cast<size_t>(this->pos) / this->block_size;
+                auto in_block = static_cast<size_t>(this->pos) % this->block_size;
+                auto &block   = this->get_block(index);
+                if (in_block >= block.size())
+                    break;
+                auto n = std::min(length - bytes_read, block.size() - in_block);
+                memcpy(buffer + bytes_read, block.data() + in_block, n);
+                bytes_read += n;
+                this->pos += n;
+                if (block.size() < this->block_size)
+                    break; // Short block: end of file
+            }
+        }
 
-#if defined(PYPY_VERSION)
-        // PyPy does not permit readinto(memoryview), so read to a buffer and
-        // memcpy that buffer. Error message is:
-        // "TypeError: a read-write bytes-like object is required, not memoryview"
-        this->last_offset = this->tell();
-        py::bytes result  = this->stream.attr("read")(length);
-        py::buffer pybuf(result);
-        py::buffer_info info = pybuf.request();
-        size_t bytes_read    = info.size * info.itemsize;
-
-        memcpy(buffer, info.ptr, std::min(length, bytes_read));
-#else
-        auto view_buffer_info = py::memoryview::from_memory(buffer, length);
-        this->last_offset     = this->tell();
-        py::object result     = this->stream.attr("readinto")(view_buffer_info);
-        if (result.is_none())
-            return 0;
-        size_t bytes_read = py::cast<size_t>(result);
-#endif
         if (bytes_read == 0) {
             if (length > 0) {
                 // EOF
-                this->seek(0, SEEK_END);
-                this->last_offset = this->tell();
+                this->pos         = this->size();
+                this->last_offset = this->pos;
             }
         }
         return bytes_read;
     }
 
-    void unreadCh(char ch) override { this->seek(-1, SEEK_CUR); }
+    void unreadCh(char ch) override
+    {
+        if (this->pos > 0)
+            --this->pos;
+    }
 
     qpdf_offset_t findAndSkipNextEOL() override
     {
-        py::gil_scoped_acquire gil;
-
         qpdf_offset_t result   = 0;
         bool done              = false;
         bool eol_straddles_buf = false;
@@ -150,8 +182,88 @@ public:
         return result;
     }
 
+    std::shared_ptr<ReadCacheStats> get_stats() const { return this->stats; }
+
 private:
+    using Block = std::vector<char>;
+
+    // Return the block that starts at index * block_size, most recently used first.
+    const Block &get_block(size_t index)
+    {
+        auto found = this->block_map.find(index);
+        if (found != this->block_map.end()) {
+            ++this->stats->hits;
+            this->blocks.splice(this->blocks.begin(), this->blocks, found->second);
+            return found->second->second;
+        }
+        ++this->stats->misses;
+
+        Block block(this->block_size);
+        auto offset = static_cast<qpdf_offset_t>(index * this->block_size);
+        block.resize(this->read_stream(offset, block.data(), block.size()));
+
+        if (this->blocks.size() >= this->block_count) {
+            this->block_map.erase(this->blocks.back().first);
+            this->blocks.pop_back();
+        }
+        this->blocks.emplace_front(index, std::move(block));
+        this->block_map[index] = this->blocks.begin();
+        return this->blocks.front().second;
+    }
+
+    // Read up to length bytes at offset, retrying short reads until EOF.
+    size_t read_stream(qpdf_offset_t offset, char *buffer, size_t length)
+    {
+        py::gil_scoped_acquire gil;
+        this->stream.attr("seek")(offset, SEEK_SET);
+        ++this->stats->stream_reads;
+
+        size_t total = 0;
+        while (total < length) {
+#if defined(PYPY_VERSION)
+            // PyPy does not permit readinto(memoryview), so read to a buffer and
+            // memcpy that buffer. Error message is:
+            // "TypeError: a read-write bytes-like object is required, not memoryview"
+            py::bytes result = this->stream.attr("read")(length - total);
+            py::buffer pybuf(result);
+            py::buffer_info info = pybuf.request();
+            size_t bytes_read =
+                std::min(length - total, static_cast<size_t>(info.size * info.itemsize));
+
+            memcpy(buffer + total, info.ptr, bytes_read);
+#else
+            auto view_buffer_info =
+                py::memoryview::from_memory(buffer + total, length - total);
+            py::object result = this->stream.attr("readinto")(view_buffer_info);
+            if (result.is_none())
+                break;
+            size_t bytes_read = py::cast<size_t>(result);
+#endif
+            if (bytes_read == 0)
+                break;
+            total += bytes_read;
+        }
+        return total;
+    }
+
+    qpdf_offset_t size()
+    {
+        if (this->stream_size < 0) {
+            py::gil_scoped_acquire gil;
+            this->stream.attr("seek")(0, SEEK_END);
+            this->stream_size = py::cast<qpdf_offset_t>(this->stream.attr("tell")());
+        }
+        return this->stream_size;
+    }
+
     py::object stream;
     std::string name;
     bool close;
+    size_t block_size;
+    size_t block_count;
+    qpdf_offset_t pos         = 0;
+    qpdf_offset_t stream_size = -1;
+    std::list<std::pair<size_t, Block>> blocks;
+    std::unordered_map<size_t, std::list<std::pair<size_t, Block>>::iterator> block_map;
+    std::shared_ptr<ReadCacheStats> stats;
 };
@@ -0,0 +1,255 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <qpdf/QPDF.hh>
+#include <qpdf/QPDFXRefEntry.hh>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "pikepdf.h"
+
+// The object IDs that were known when a Pdf's object table was first requested.
+// Objects in the cross-reference table are known immediately, without parsing
+// them. Objects created since the file was opened are not in the cross-reference
+// table, and QPDF can only count them by resolving every object (see
+// QPDF::getObjectCount), so they are found the first time they are needed.
+struct ObjectTableIds {
+    std::vector<QPDFObjGen> xref;
+    std::vector<bool> in_object_stream; // Parallel to xref
+    int max_xref_id = 0;
+
+    bool created_known = false;
+    std::vector<QPDFObjGen> created;
+};
+
+class ObjectTable {
+public:
+    explicit ObjectTable(std::shared_ptr<QPDF> q)
+        : qpdf(q), ids(std::make_shared<ObjectTableIds>())
+    {
+        for (auto &entry : q->getXRefTable()) {
+            this->ids->xref.push_back(entry.first);
+            this->ids->in_object_stream.push_back(entry.second.getType() == 2);
+            this->ids->max_xref_id =
+                std::max(this->ids->max_xref_id, entry.first.getObj());
+        }
+    }
+    size_t count_xref() const { return this->ids->xref.size(); }
+
+    // Reads every object the first time, unless created objects are known
+    size_t count() { return this->count_xref() + this->created().size(); }
+
+    bool created_known() const { return this->ids->created_known; }
+
+    QPDFObjGen objgen(size_t index)
+    {
+        if (index < this->count_xref())
+            return this->ids->xref[index];
+        index -= this->count_xref();
+        if (index < this->created().size())
+            return this->created()[index];
+        throw py::index_error("object table index out of range");
+    }
+
+    QPDFObjectHandle get(size_t index)
+    {
+        return this->qpdf->getObjectByObjGen(this->objgen(index));
+    }
+
+    // Return the objects for which pred(object) is true. If streams_only is set,
+    // objects stored in object streams are skipped without being parsed, because
+    // streams cannot be stored there.
+    template <typename Predicate>
+    std::vector<QPDFObjectHandle> select(bool streams_only, Predicate pred)
+    {
+        std::vector<QPDFObjectHandle> result;
+        for (size_t i = 0; i < this->count_xref(); ++i) {
+            if (streams_only && this->ids->in_object_stream[i])
+                continue;
+            auto h = this->qpdf->getObjectByObjGen(this->ids->xref[i]);
+            if (pred(h))
+                result.push_back(h);
+        }
+        for (auto &og : this->created()) {
+            auto h = this->qpdf->getObjectByObjGen(og);
+            if (pred(h))
+                result.push_back(h);
+        }
+        return result;
+    }
+
+    std::vector<QPDFObjectHandle> of_type(QPDFObject::object_type_e type)
+    {
+        return this->select(type == QPDFObject::ot_stream,
+            [type](QPDFObjectHandle &h) { return h.getTypeCode() == type; });
+    }
+
+    std::shared_ptr<QPDF> qpdf;
+
+private:
+    const std::vector<QPDFObjGen> &created()
+    {
+        if (!this->ids->created_known) {
+            // New objects are numbered consecutively after the highest object
+            // number that QPDF knows about
+            auto highest = static_cast<int>(this->qpdf->getObjectCount());
+            for (int id = this->ids->max_xref_id + 1; id <= highest; ++id)
+                this->ids->created.emplace_back(id, 0);
+            this->ids->created_known = true;
+        }
+        return this->ids->created;
+    }
+
+    std::shared_ptr<ObjectTableIds> ids;
+};
+
+// Criteria for Pdf.find_objects(). Empty strings match anything.
+struct ObjectQuery {
+    std::string type;
+    std::string subtype;
+    std::vector<std::string> keys;
+    std::string filter;
+
+    static bool is_name(QPDFObjectHandle h, const std::string &name)
+    {
+        return h.isName() && h.getName() == name;
+    }
+
+    bool matches(QPDFObjectHandle &h) const
+    {
+        QPDFObjectHandle dict;
+        if (h.isStream())
+            dict = h.getDict();
+        else if (h.isDictionary() && this->filter.empty())
+            dict = h;
+        else
+            return false;
+
+        if (!this->type.empty() && !is_name(dict.getKey("/Type"), this->type))
+            return false;
+        if (!this->subtype.empty() && !is_name(dict.getKey("/Subtype"), this->subtype))
+            return false;
+        for (auto &key : this->keys)
+            if (!dict.hasKey(key))
+                return false;
+        if (!this->filter.empty()) {
+            auto filters = dict.getKey("/Filter");
+            if (filters.isArray()) {
+                for (auto &item : filters.getArrayAsVector())
+                    if (is_name(item, this->filter))
+                        return true;
+                return false;
+            }
+            return is_name(filters, this->filter);
+        }
+        return true;
+    }
+};
+
+static size_t table_index(ObjectTable &table, py::ssize_t index)
+{
+    if (index < 0)
+        index += table.count();
+    if (index < 0)
+        throw py::index_error("object table index out of range");
+    return static_cast<size_t>(index);
+}
+
+// Iterates over a copy of an ObjectTable, which shares its object IDs. Kept apart
+// from the table so that iter() on an iterator returns it unchanged, as Python
+// expects, instead of starting again.
+class ObjectTableIterator {
+public:
+    explicit ObjectTableIterator(const ObjectTable &table) : table(table) {}
+
+    QPDFObjectHandle next()
+    {
+        // Only look for created objects once the objects in the cross-reference
+        // table have been visited
+        if (this->pos < this->table.count_xref() || this->pos < this->table.count())
+            return this->table.get(this->pos++);
+        throw py::stop_iteration();
+    }
+
+private:
+    ObjectTable table;
+    size_t pos = 0;
+};
+
+py::object object_table(std::shared_ptr<QPDF> q) { return py::cast(ObjectTable(q)); }
+
+void init_objects(py::module_ &m)
+{
+    py::class_<ObjectTableIterator>(m, "_ObjectTableIterator")
+        .def("__iter__",
+            [](ObjectTableIterator &it) -> ObjectTableIterator & { return it; },
+            py::return_value_policy::reference_internal)
+        .def("__next__", &ObjectTableIterator::next);
+
+    py::class_<ObjectTable>(m, "_ObjectTable")
+        .def("__len__",
+            &ObjectTable::count,
+            "Count the objects. The first call may read every object in the file.")
+        .def("__getitem__",
+            [](ObjectTable &table, py::ssize_t index) {
+                return table.get(table_index(table, index));
+            })
+        .def("__getitem__",
+            [](ObjectTable &table, py::slice slice) {
+                size_t start, stop, step, slicelength;
+                if (!slice.compute(table.count(), &start, &stop, &step, &slicelength))
+                    throw py::error_already_set();
+                py::list result;
+                for (size_t i = 0; i < slicelength; ++i, start += step)
+                    result.append(table.get(start));
+                return result;
+            })
+        .def("__iter__",
+            [](ObjectTable &table) { return ObjectTableIterator(table); })
+        .def("of_type",
+            &ObjectTable::of_type,
+            R"~~~(
+            Return all objects of a type, such as ``ObjectType.stream``.
+
+            The objects are examined without creating a Python object for each
+            one, and objects stored in object streams are not parsed when
+            looking for streams, because streams cannot be stored there.
+
+            Args:
+                type (pikepdf.ObjectType): Type of object to return.
+
+            Return type:
+                list
+            )~~~",
+            py::arg("type"))
+        .def(
+            "_find",
+            [](ObjectTable &table,
+                std::string type,
+                std::string subtype,
+                std::vector<std::string> keys,
+                std::string filter) {
+                ObjectQuery query{type, subtype, keys, filter};
+                return table.select(!filter.empty(),
+                    [&query](QPDFObjectHandle &h) { return query.matches(h); });
+            })
+        .def("__repr__", [](ObjectTable &table) {
+            // Don't count created objects here, since that reads the whole file
+            if (table.created_known())
+                return std::string("<pikepdf._qpdf._ObjectTable len=") +
+                       std::to_string(table.count()) + std::string(">");
+            return std::string("<pikepdf._qpdf._ObjectTable len>=") +
+                   std::to_string(table.count_xref()) + std::string(">");
+        });
+}
@@ -6,8 +6,12 @@
  * Copyright (C) 2017, James R. Barlow (https://github.com/jbarlow83/)
  */
 
+#include <algorithm>
+#include <thread>
+
 #include "pikepdf.h"
 #include "qpdf_pagelist.h"
+#include "qpdf_state.h"
 
 #include <qpdf/QPDFPageObjectHelper.hh>
 #include <qpdf/QPDFPageDocumentHelper.hh>
@@ -35,11 +39,85 @@ size_t uindex_from_index(PageList &pl, py::ssize_t index)
     return uindex;
 }
 
+void PageIndex::rebuild(const std::vector<QPDFObjectHandle> &pages)
+{
+    this->positions.clear();
+    this->positions.reserve(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i) {
+        this->positions[pages[i].getObjGen()] = i;
+    }
+    this->npages = pages.size();
+    this->valid  = true;
+}
+
+size_t PageIndex::find(QPDF &q, QPDFObjGen og)
+{
+    auto &pages  = q.getAllPages();
+    bool rebuilt = false;
+    if (!this->valid || this->npages != pages.size()) {
+        this->rebuild(pages);
+        rebuilt = true;
+    }
+    for (;;) {
+        auto it = this->positions.find(og);
+        if (it != this->positions.end() && it->second < pages.size() &&
+            pages[it->second].getObjGen() == og)
+            return it->second;
+        if (rebuilt)
+            break;
+        // The page list was changed behind our back, so trust QPDF instead
+        this->rebuild(pages);
+        rebuilt = true;
+    }
+    throw py::value_error("Page is not consistently registered with Pdf");
+}
+
+void PageIndex::page_inserted(QPDF &q, size_t index)
+{
+    auto &pages = q.getAllPages();
+    if (this->valid && index == this->npages && pages.size() == this->npages + 1) {
+        // Foreign pages are copied on insertion, so use the objgen of the copy
+        this->positions[pages[index].getObjGen()] = index;
+        this->npages++;
+    } else {
+        // Inserting in the middle shifts every later page, so defer that work
+        // until someone asks
+        this->invalidate();
+    }
+}
+
+void PageIndex::page_removed(QPDF &q, size_t index, QPDFObjGen og)
+{
+    if (this->valid && index + 1 == this->npages &&
+        q.getAllPages().size() == this->npages - 1) {
+        this->positions.erase(og);
+        this->npages--;
+    } else {
+        this->invalidate();
+    }
+}
+
+void PageIndex::invalidate()
+{
+    this->valid = false;
+    this->positions.clear();
+}
+
+// QPDF keeps its own cache of the page list, which it updates as pages are inserted
+// and removed. Borrow it rather than copying it - a copy costs O(n) allocations and
+// refcount updates per page access, which makes iterating over pages O(n^2).
+// The reference is invalidated by any insertion or deletion, so callers must not
+// hold it across those.
+const std::vector<QPDFObjectHandle> &PageList::pages() const
+{
+    return this->qpdf->getAllPages();
+}
+
 QPDFObjectHandle PageList::get_page_obj(size_t index) const
 {
-    auto pages = this->qpdf->getAllPages();
+    auto &pages = this->pages();
     if (index < pages.size())
-        return pages.at(index);
+        return pages[index];
     throw py::index_error("Accessing nonexistent PDF page number");
 }
 
@@ -53,10 +131,11 @@ std::vector<QPDFObjectHandle> PageList::get_page_objs_impl(py::slice slice) cons
     size_t start, stop, step, slicelength;
     if (!slice.compute(this->count(), &start, &stop, &step, &slicelength))
         throw py::error_already_set(); // LCOV_EXCL_LINE
+    auto &pages = this->pages();
     std::vector<QPDFObjectHandle> result;
+    result.reserve(slicelength);
     for (size_t i = 0; i < slicelength; ++i) {
-        auto oh = this->get_page_obj(start);
-        result.push_back(oh);
+        result.push_back(pages.at(start));
         start += step;
     }
     return result;
@@ -129,6 +208,9 @@ void PageList::delete_page(size_t index)
 {
     auto page = this->get_page_obj(index);
     this->qpdf->removePage(page);
+    get_pdf_state(*this->qpdf).page_index.page_removed(
+        *this->qpdf, index, page.getObjGen());
+    journal_pages_changed(*this->qpdf);
 }
 
 void PageList::delete_pages_from_iterable(py::slice slice)
@@ -140,9 +222,11 @@ void PageList::delete_pages_from_iterable(py::slice slice)
     for (auto page : kill_list) {
         this->qpdf->removePage(page);
     }
+    get_pdf_state(*this->qpdf).page_index.invalidate();
+    journal_pages_changed(*this->qpdf);
 }
 
-size_t PageList::count() const { return this->qpdf->getAllPages().size(); }
+size_t PageList::count() const { return this->pages().size(); }
 
 void PageList::insert_page(size_t index, py::handle obj)
 {
@@ -196,6 +280,11 @@ void PageList::insert_page(size_t index, QPDFPageObjectHelper poh)
         } else {
             doc.addPage(page, false);
         }
+        get_pdf_state(*this->qpdf).page_index.page_inserted(*this->qpdf, index);
+        note_copied_from(*this->qpdf, handle_owner);
+        // A page from another PDF was copied, along with what it refers to
+        journal_updated(this->get_page_obj(index));
+        journal_pages_changed(*this->qpdf);
     } catch (const std::runtime_error &e) {
         if (copied) {
             // If we created a new object to hold the page, and failed, delete
@@ -215,6 +304,23 @@ QPDFPageObjectHelper from_objgen(QPDF &q, QPDFObjGen og)
     return QPDFPageObjectHelper(h);
 }
 
+static NativePageOp native_page_op(py::handle op)
+{
+    if (py::isinstance<ContentRules>(op))
+        return {NativePageOp::content_rules, op.cast<ContentRules &>().rule_set()};
+    if (py::isinstance<py::str>(op)) {
+        auto name = op.cast<std::string>();
+        if (name == "coalesce")
+            return {NativePageOp::coalesce, nullptr};
+        if (name == "remove_unreferenced_resources")
+            return {NativePageOp::remove_unreferenced_resources, nullptr};
+        throw py::value_error("unknown page operation: " + name);
+    }
+    throw py::type_error(
+        "page operations must be pikepdf.ContentRules, 'coalesce' or "
+        "'remove_unreferenced_resources'");
+}
+
 void init_pagelist(py::module_ &m)
 {
     py::class_<PageList>(m, "PageList")
@@ -355,6 +461,57 @@ void init_pagelist(py::module_ &m)
             A ``ValueError`` exception is thrown if the page does not belong to
             to this ``Pdf``.
             )~~~")
+        .def(
+            "map_native",
+            [](PageList &pl, py::object op, py::object workers) {
+                std::vector<NativePageOp> ops;
+                if (py::isinstance<py::str>(op) || py::isinstance<ContentRules>(op)) {
+                    ops.push_back(native_page_op(op));
+                } else {
+                    for (auto item : op.cast<py::iterable>())
+                        ops.push_back(native_page_op(item));
+                }
+                size_t nworkers = workers.is_none()
+                                      ? std::max(1u, std::thread::hardware_concurrency())
+                                      : workers.cast<size_t>();
+                map_pages_native(*pl.qpdf, ops, nworkers);
+            },
+            py::arg("op"),
+            py::kw_only(),
+            py::arg("workers") = py::none(),
+            R"~~~(
+            Apply built-in page operations to every page, using several threads.
+
+            Each page's content stream is read and decoded, then the operations
+            run on the decoded content of all pages in parallel, without the GIL.
+            Finally the results are written back to the pages one at a time.
+
+            Args:
+                op: An operation, or a sequence of them. Operations are:
+
+                    - a :class:`pikepdf.ContentRules`, which is applied to the
+                      page's content stream;
+                    - ``'coalesce'``, which combines the page's content streams
+                      into one stream, as :meth:`pikepdf.Page.contents_coalesce`
+                      does;
+                    - ``'remove_unreferenced_resources'``, which removes resources
+                      that the page's content does not use, after all other
+                      operations have been applied.
+
+                    Content rules are applied in order. If there are any content
+                    rules or ``'coalesce'`` is given, every page receives a new,
+                    single content stream, and token filters previously added with
+                    :meth:`pikepdf.Page.add_content_token_filter` are applied to
+                    it.
+                workers (int): Number of threads to use. Defaults to the number
+                    of CPUs.
+
+            Unlike :meth:`pikepdf.Page.remove_unreferenced_resources`, resources
+            of Form XObjects are not examined, and resources of pages that draw a
+            Form XObject that has no resources of its own are left alone.
+
+            .. versionadded:: 3.0
+            )~~~")
         .def("__repr__",
             [](PageList &pl) {
                 return std::string("<pikepdf._qpdf.PageList len=") +
@@ -10,12 +10,49 @@
 
 #include "pikepdf.h"
 
+#include <memory>
+#include <unordered_map>
+
 #include <pybind11/stl.h>
 
 #include <qpdf/QPDFPageObjectHelper.hh>
 
+#include "tokenfilter.h"
+
 void init_pagelist(py::module_ &m);
 
+// One operation of Pdf.pages.map_native()
+struct NativePageOp {
+    enum Kind { coalesce, content_rules, remove_unreferenced_resources };
+    Kind kind;
+    std::shared_ptr<const ContentRuleSet> rules; // For content_rules only
+};
+
+// From page.cpp
+void map_pages_native(QPDF &q, const std::vector<NativePageOp> &ops, size_t workers);
+
+// Reverse lookup from a page's objgen to its position in the page list.
+// QPDF keeps the same mapping privately, but does not expose it.
+//
+// The index is updated in place for the common case of appending or removing
+// the last page, and otherwise rebuilt lazily on the next lookup. Every lookup is
+// checked against QPDF's page list, so pages added or removed by other means
+// (e.g. Pdf._add_page_at) cause a rebuild rather than a wrong answer.
+class PageIndex {
+public:
+    size_t find(QPDF &q, QPDFObjGen og);
+    void page_inserted(QPDF &q, size_t index);
+    void page_removed(QPDF &q, size_t index, QPDFObjGen og);
+    void invalidate();
+
+private:
+    void rebuild(const std::vector<QPDFObjectHandle> &pages);
+
+    std::unordered_map<QPDFObjGen, size_t, ObjGenHash> positions;
+    size_t npages = 0;
+    bool valid    = false;
+};
+
 class PageList {
 public:
     PageList(std::shared_ptr<QPDF> q, size_t iterpos = 0) : iterpos(iterpos), qpdf(q){};
@@ -36,5 +73,6 @@ public:
     std::shared_ptr<QPDF> qpdf;
 
 private:
+    const std::vector<QPDFObjectHandle> &pages() const;
     std::vector<QPDFObjectHandle> get_page_objs_impl(py::slice slice) const;
 };
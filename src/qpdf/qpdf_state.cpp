@@ -0,0 +1,239 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "pikepdf.h"
+#include "qpdf_state.h"
+
+using PdfStateRegistry = std::unordered_map<const QPDF *, std::unique_ptr<PdfState>>;
+
+// The registry is deliberately leaked, so that QPDFs released during interpreter
+// shutdown never find it already destroyed.
+static PdfStateRegistry &registry()
+{
+    static auto *states = new PdfStateRegistry();
+    return *states;
+}
+
+static std::mutex &registry_mutex()
+{
+    static auto *mutex = new std::mutex();
+    return *mutex;
+}
+
+static void forget_pdf_state(const QPDF *q)
+{
+    std::unique_ptr<PdfState> state;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto it = registry().find(q);
+        if (it == registry().end())
+            return;
+        state = std::move(it->second);
+        registry().erase(it);
+    }
+    // state is destroyed here, outside the lock
+}
+
+std::shared_ptr<QPDF> make_qpdf()
+{
+    return std::shared_ptr<QPDF>(new QPDF(), [](QPDF *q) {
+        forget_pdf_state(q);
+        delete q;
+    });
+}
+
+PdfState &get_pdf_state(QPDF &q)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    auto &state = registry()[&q];
+    if (!state)
+        state = std::make_unique<PdfState>();
+    return *state;
+}
+
+bool pdf_calls_python(QPDF &q)
+{
+    auto &state = get_pdf_state(q);
+    return state.read_cache != nullptr || state.calls_python;
+}
+
+void note_copied_from(QPDF &q, QPDF *source)
+{
+    if (source && source != &q && pdf_calls_python(*source))
+        get_pdf_state(q).calls_python = true;
+}
+
+void note_stream_data(
+    QPDFObjectHandle h, PointerHolder<QPDFObjectHandle::StreamDataProvider> provider)
+{
+    if (auto *q = h.getOwningQPDF())
+        get_pdf_state(*q).stream_data_sources[h.getObjGen()] = provider;
+}
+
+static ChangeJournal *journal_for(QPDFObjectHandle &h)
+{
+    if (!h.isIndirect())
+        return nullptr;
+    auto *q = h.getOwningQPDF();
+    return q ? &get_pdf_state(*q).journal : nullptr;
+}
+
+void journal_created(QPDFObjectHandle h)
+{
+    if (!h.isIndirect() || !h.getOwningQPDF())
+        return;
+    auto &state = get_pdf_state(*h.getOwningQPDF());
+    state.journal.created.insert(h.getObjGen());
+    state.max_created_objid = std::max(state.max_created_objid, h.getObjectID());
+}
+
+void journal_modified(QPDFObjectHandle h)
+{
+    auto *journal = journal_for(h);
+    if (!journal)
+        return;
+    auto og = h.getObjGen();
+    if (!journal->created.count(og))
+        journal->modified.insert(og);
+}
+
+void journal_replaced(QPDF &q, QPDFObjGen og, QPDFObjectHandle replacement)
+{
+    get_pdf_state(q).stream_data_sources.erase(og);
+    get_pdf_state(q).journal_snapshots.erase(og);
+    auto &journal = get_pdf_state(q).journal;
+    if (replacement.isNull()) {
+        journal.modified.erase(og);
+        // An object created and deleted since the checkpoint was never there
+        if (!journal.created.erase(og))
+            journal.deleted.insert(og);
+    } else if (!journal.created.count(og)) {
+        journal.deleted.erase(og);
+        journal.modified.insert(og);
+    }
+}
+
+void journal_updated(QPDF &q, const std::vector<QPDFObjectHandle> &handles)
+{
+    auto &state = get_pdf_state(q);
+    if (state.max_xref_objid < 0) {
+        state.max_xref_objid = 0;
+        for (auto &entry : q.getXRefTable())
+            state.max_xref_objid = std::max(state.max_xref_objid, entry.first.getObj());
+    }
+    // qpdf numbers new objects after the highest object number in use, so
+    // anything above every object pikepdf knows of is new. Old objects are not
+    // followed, so only what was created is walked.
+    int known = std::max(state.max_xref_objid, state.max_created_objid);
+    std::unordered_set<QPDFObjGen, ObjGenHash> seen;
+    std::vector<QPDFObjectHandle> pending;
+    auto push_items = [&pending](QPDFObjectHandle item) {
+        if (item.isStream())
+            item = item.getDict();
+        if (item.isArray()) {
+            for (auto &child : item.getArrayAsVector())
+                pending.push_back(child);
+        } else if (item.isDictionary()) {
+            for (auto &child : item.getDictAsMap())
+                pending.push_back(child.second);
+        }
+    };
+
+    for (auto &h : handles) {
+        if (!seen.insert(h.getObjGen()).second)
+            continue;
+        if (h.isIndirect() && h.getObjectID() > known)
+            journal_created(h);
+        else
+            journal_modified(h);
+        push_items(h);
+    }
+    while (!pending.empty()) {
+        auto item = pending.back();
+        pending.pop_back();
+        if (item.isIndirect()) {
+            if (item.getObjectID() <= known || !seen.insert(item.getObjGen()).second)
+                continue;
+            journal_created(item);
+        }
+        push_items(item);
+    }
+}
+
+void journal_updated(QPDFObjectHandle h)
+{
+    if (auto *q = h.getOwningQPDF())
+        journal_updated(*q, {h});
+}
+
+void journal_pages_changed(QPDF &q)
+{
+    // The page tree is flat once qpdf has changed it
+    journal_modified(q.getRoot().getKey("/Pages"));
+}
+
+void journal_incomplete(QPDF &q) { get_pdf_state(q).journal.incomplete = true; }
+
+static std::string journal_snapshot(QPDFObjectHandle h)
+{
+    return h.isStream() ? h.getDict().unparse() : h.unparseResolved();
+}
+
+void journal_watch(QPDFObjectHandle parent, QPDFObjectHandle child)
+{
+    if (child.isIndirect() || !(child.isArray() || child.isDictionary()))
+        return;
+    if (!parent.isIndirect() || !parent.getOwningQPDF())
+        return; // Nested deeper, so its indirect container is already watched
+    auto &snapshots = get_pdf_state(*parent.getOwningQPDF()).journal_snapshots;
+    auto og         = parent.getObjGen();
+    if (!snapshots.count(og))
+        snapshots[og] = journal_snapshot(parent);
+}
+
+void journal_update_watched(QPDF &q)
+{
+    for (auto &entry : get_pdf_state(q).journal_snapshots) {
+        auto h       = q.getObjectByObjGen(entry.first);
+        auto current = journal_snapshot(h);
+        if (current != entry.second) {
+            journal_modified(h);
+            entry.second = std::move(current);
+        }
+    }
+}
+
+void journal_checkpoint(QPDF &q)
+{
+    journal_update_watched(q);
+    get_pdf_state(q).journal = ChangeJournal();
+}
+
+PdfSaveLock::PdfSaveLock(QPDF &q) : state(get_pdf_state(q))
+{
+    if (this->state.saving_thread == std::this_thread::get_id())
+        throw py::value_error("cannot save or close a Pdf while it is being saved");
+    if (!this->state.save_mutex.try_lock()) {
+        // Whoever holds the lock may need the GIL to finish
+        py::gil_scoped_release release;
+        this->state.save_mutex.lock();
+    }
+    this->state.saving_thread = std::this_thread::get_id();
+}
+
+PdfSaveLock::~PdfSaveLock()
+{
+    this->state.saving_thread = std::thread::id();
+    this->state.save_mutex.unlock();
+}
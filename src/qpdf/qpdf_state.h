@@ -0,0 +1,203 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <qpdf/QPDF.hh>
+
+#include "pikepdf.h"
+#include "qpdf_pagelist.h"
+#include "gsl.h"
+
+// Counters for the block cache of a PDF opened from a Python stream.
+struct ReadCacheStats {
+    size_t block_size   = 0;
+    size_t block_count  = 0;
+    size_t hits         = 0;
+    size_t misses       = 0;
+    size_t stream_reads = 0;
+};
+
+// How a PDF was opened from a file, so that independent read-only views of the
+// same file can be opened later, for example by worker threads. The copy kept in
+// PdfState has no password; views of encrypted files cannot be reopened.
+struct SourceFile {
+    std::string path;
+    std::string password;
+    bool hex_password        = false;
+    bool ignore_xref_streams = false;
+    bool attempt_recovery    = true;
+};
+
+// Indirect objects changed through pikepdf since the PDF was opened or since the
+// last checkpoint. A direct object does not know which object contains it, so a
+// change to a direct object nested in another object is found by comparing the
+// containing object with a snapshot taken when pikepdf handed out its contents.
+struct ChangeJournal {
+    std::set<QPDFObjGen> created;
+    std::set<QPDFObjGen> modified; // Excludes objects that are in created
+    std::set<QPDFObjGen> deleted;  // Replaced with null
+
+    // Set when qpdf changed objects in ways that pikepdf does not follow
+    bool incomplete = false;
+};
+
+// SHA-256 digests of indirect objects, as computed by Object.content_digest()
+using DigestCache = std::unordered_map<QPDFObjGen, std::string, ObjGenHash>;
+
+// Native bookkeeping that pikepdf keeps for each QPDF, in addition to what QPDF
+// tracks itself. Access it with get_pdf_state() while holding the GIL, or before
+// the QPDF has been shared with Python.
+struct PdfState {
+    PageIndex page_index;
+    std::shared_ptr<ReadCacheStats> read_cache; // Null unless opened from a stream
+    std::unique_ptr<SourceFile> source_file;    // Null unless opened from a path
+
+    ChangeJournal journal;
+
+    // Unparsed indirect objects whose direct contents were handed out to Python,
+    // as they were when last compared; kept across checkpoints
+    std::unordered_map<QPDFObjGen, std::string, ObjGenHash> journal_snapshots;
+
+    // Objects numbered above these were created since the PDF was opened; the
+    // first is -1 until needed
+    int max_xref_objid    = -1;
+    int max_created_objid = 0;
+
+    // Set once writing this PDF may call back into Python through something other
+    // than its own input source: a Python token filter, a Python stream data
+    // provider, or objects copied from a PDF that does. See pdf_calls_python().
+    bool calls_python = false;
+
+    // How pikepdf last set the data of streams: from the provider, or from a
+    // buffer if it is null. Lets precompress_streams() give a stream its data
+    // back without reading it.
+    std::unordered_map<QPDFObjGen,
+        PointerHolder<QPDFObjectHandle::StreamDataProvider>,
+        ObjGenHash>
+        stream_data_sources;
+
+    // PDFs whose pages were copied in by Pdf.merge(). Copied streams read their
+    // data from these, so they are kept open for as long as this PDF.
+    std::vector<std::shared_ptr<QPDF>> merged_sources;
+
+    // Filled only when content_digest(cache=True) is used; stale once the
+    // digested objects are modified, until cleared
+    DigestCache raw_digests;
+    DigestCache decoded_digests;
+
+    // Held while the PDF is being saved without the GIL, so that a second save or
+    // a close of the same PDF from another thread waits for it to finish.
+    std::mutex save_mutex;
+    std::atomic<std::thread::id> saving_thread{};
+};
+
+// Create a QPDF whose PdfState is discarded when the QPDF is deleted. All QPDFs
+// that are handed to Python should be created this way.
+std::shared_ptr<QPDF> make_qpdf();
+
+PdfState &get_pdf_state(QPDF &q);
+
+// Whether writing q may call into Python: its input source is a Python stream,
+// or calls_python is set
+bool pdf_calls_python(QPDF &q);
+
+// Record that objects were copied into q from source, which may read their data
+// through Python when q is written
+void note_copied_from(QPDF &q, QPDF *source);
+
+// Record that pikepdf set the data of stream h, from provider or, if it is null,
+// from a buffer. Call with the GIL held.
+void note_stream_data(QPDFObjectHandle h,
+    PointerHolder<QPDFObjectHandle::StreamDataProvider> provider =
+        PointerHolder<QPDFObjectHandle::StreamDataProvider>());
+
+// Record changes in the journal of the PDF that owns the object. Objects without
+// an owner, and direct objects, are ignored. Call with the GIL held.
+void journal_created(QPDFObjectHandle h);
+void journal_modified(QPDFObjectHandle h);
+void journal_replaced(QPDF &q, QPDFObjGen og, QPDFObjectHandle replacement);
+
+// Record that qpdf modified h, and created any objects that h now refers to,
+// directly or not, such as copies of foreign objects. Pass everything changed by
+// one operation at once: objects created by it are told apart by their numbers.
+void journal_updated(QPDFObjectHandle h);
+void journal_updated(QPDF &q, const std::vector<QPDFObjectHandle> &handles);
+
+// Record that the page tree of q was rearranged
+void journal_pages_changed(QPDF &q);
+
+// Record that qpdf changed q in ways the journal does not show
+void journal_incomplete(QPDF &q);
+
+// Call before handing child, an item of parent, to Python: if child is a direct
+// array or dictionary, it may be modified without parent knowing
+void journal_watch(QPDFObjectHandle parent, QPDFObjectHandle child);
+
+// Record the changes to watched objects; then, for journal_checkpoint(), start
+// a new journal
+void journal_update_watched(QPDF &q);
+void journal_checkpoint(QPDF &q);
+
+// Holds a PDF's save_mutex for as long as it exists. Construct it with the GIL
+// held; the GIL is released while waiting for another thread's save to finish.
+// Throws if this thread is already saving the PDF, for example if a progress
+// callback tries to close it.
+class PdfSaveLock {
+public:
+    explicit PdfSaveLock(QPDF &q);
+    ~PdfSaveLock();
+    PdfSaveLock(const PdfSaveLock &) = delete;
+    PdfSaveLock &operator=(const PdfSaveLock &) = delete;
+
+private:
+    PdfState &state;
+};
+
+// Open a new QPDF from source and record source in its state. Does not need the
+// GIL, so it may be called from worker threads.
+std::shared_ptr<QPDF> open_source_file(const SourceFile &source, bool suppress_warnings);
+
+// A PDF to merge: an open PDF, or the path of one to open
+struct MergeSource {
+    std::string path;
+    std::shared_ptr<QPDF> pdf; // Opened from path if null
+};
+
+// Append the pages of every source to q, in order, and return how many were
+// added. Sources given by path are opened on worker threads, a few ahead of the
+// source being copied, using the options in how_to_open. Call with the GIL held.
+size_t merge_sources(QPDF &q,
+    const std::vector<MergeSource> &sources,
+    size_t workers,
+    const SourceFile &how_to_open);
+
+// Run fn(worker_number) on workers threads, including this one, and wait for all
+// of them. fn must not throw.
+template <typename F>
+void run_workers(size_t workers, F fn)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    auto join_all = gsl::finally([&threads] {
+        for (auto &thread : threads)
+            thread.join();
+    });
+    for (size_t n = 1; n < workers; ++n)
+        threads.emplace_back(fn, n);
+    fn(0); // The calling thread does its share of the work too
+}
@@ -10,11 +10,16 @@
 #include <iostream>
 #include <iomanip>
 #include <cctype>
+#include <cmath>
+#include <locale>
 
 #include "pikepdf.h"
+#include "tokenfilter.h"
 
 #include <qpdf/QPDFObjectHandle.hh>
 #include <qpdf/QPDFPageObjectHelper.hh>
+#include <qpdf/Pl_Buffer.hh>
+#include <qpdf/Pl_QPDFTokenizer.hh>
 
 class TokenFilter : public QPDFObjectHandle::TokenFilter {
 public:
@@ -24,6 +29,8 @@ public:
 
     void handleToken(Token const &token) override
     {
+        // Token filters may run while saving, when the GIL is not held
+        py::gil_scoped_acquire gil;
         py::object result = this->handle_token(token);
         if (result.is_none())
             return;
@@ -56,6 +63,256 @@ public:
     }
 };
 
+bool ContentRules::is_resource_operator(const std::string &op)
+{
+    static const std::set<std::string> resource_operators = {
+        "Do", "Tf", "gs", "CS", "cs", "SCN", "scn", "sh", "BDC", "DP"};
+    return resource_operators.count(op) != 0;
+}
+
+std::string ContentRules::apply(
+    std::shared_ptr<const ContentRuleSet> rules, const std::string &content)
+{
+    ContentRules filter(std::move(rules));
+    Pl_Buffer output("content rules output");
+    Pl_QPDFTokenizer tokenizer("content rules", &filter, &output);
+    tokenizer.write(
+        reinterpret_cast<unsigned char *>(const_cast<char *>(content.data())),
+        content.size());
+    tokenizer.finish();
+
+    PointerHolder<Buffer> buf(output.getBuffer());
+    return std::string(reinterpret_cast<const char *>(buf->getBuffer()), buf->getSize());
+}
+
+void ContentRules::handleToken(Token const &token)
+{
+    switch (token.getType()) {
+    case QPDFTokenizer::tt_eof:
+        this->flushPending();
+        break;
+    case QPDFTokenizer::tt_space:
+    case QPDFTokenizer::tt_comment:
+        if (this->pending.empty())
+            this->writeToken(token);
+        else
+            this->pending.push_back(token);
+        break;
+    case QPDFTokenizer::tt_word:
+        this->handleOperator(token);
+        break;
+    default:
+        this->pending.push_back(token);
+    }
+}
+
+void ContentRules::handleEOF() { this->flushPending(); }
+
+void ContentRules::handleOperator(Token const &op_token)
+{
+    const auto &op = op_token.getValue();
+
+    // Inline images are BI <metadata> ID <data> EI; keep or drop them whole
+    if (this->in_inline_image) {
+        this->pending.push_back(op_token);
+        if (op == "EI") {
+            this->in_inline_image = false;
+            if (this->rules->drop_operators.count("BI"))
+                this->pending.clear();
+            this->flushPending();
+        }
+        return;
+    }
+    if (op == "BI") {
+        this->in_inline_image = true;
+        this->pending.push_back(op_token);
+        return;
+    }
+
+    if (this->rules->drop_operators.count(op)) {
+        this->pending.clear();
+        return;
+    }
+    if (this->rules->strip_text && this->stripTextOperator(op))
+        return;
+    if (this->replaceColor(op))
+        return;
+    if (!this->rules->rename_resources.empty() && is_resource_operator(op))
+        this->renameResources();
+    this->pending.push_back(op_token);
+    this->flushPending();
+}
+
+// Text showing operators are removed, but the line and spacing changes that
+// ' and " also make are kept
+bool ContentRules::stripTextOperator(const std::string &op)
+{
+    if (op == "Tj" || op == "TJ") {
+        this->pending.clear();
+        return true;
+    }
+    if (op == "'") {
+        this->pending.clear();
+        this->write("T*");
+        return true;
+    }
+    if (op == "\"") {
+        auto operands = this->operands();
+        if (operands.size() == 3) {
+            this->write(operands[0]->getRawValue() + " Tw " +
+                        operands[1]->getRawValue() + " Tc T*");
+        }
+        this->pending.clear();
+        return true;
+    }
+    return false;
+}
+
+static bool colors_match(const std::vector<double> &rule, const std::vector<double> &color)
+{
+    if (rule.size() != color.size())
+        return false;
+    for (size_t i = 0; i < rule.size(); ++i)
+        if (std::fabs(rule[i] - color[i]) > 1e-4)
+            return false;
+    return true;
+}
+
+static double to_double(const std::string &s)
+{
+    std::istringstream ss(s);
+    ss.imbue(std::locale::classic());
+    double value = 0.0;
+    ss >> value;
+    return value;
+}
+
+static std::string format_number(double value)
+{
+    std::ostringstream ss;
+    ss.imbue(std::locale::classic());
+    ss << std::fixed << std::setprecision(6) << value;
+    auto s = ss.str();
+    s.erase(s.find_last_not_of('0') + 1);
+    if (s.back() == '.')
+        s.pop_back();
+    if (s == "-0")
+        s = "0";
+    return s;
+}
+
+bool ContentRules::replaceColor(const std::string &op)
+{
+    if (this->rules->replace_colors.empty() || op.size() > 2)
+        return false;
+    bool stroke;
+    if (op == "g" || op == "rg" || op == "k")
+        stroke = false;
+    else if (op == "G" || op == "RG" || op == "K")
+        stroke = true;
+    else
+        return false;
+
+    std::vector<double> color;
+    for (auto *operand : this->operands()) {
+        auto type = operand->getType();
+        if (type != QPDFTokenizer::tt_integer && type != QPDFTokenizer::tt_real)
+            return false;
+        color.push_back(to_double(operand->getValue()));
+    }
+
+    for (const auto &rule : this->rules->replace_colors) {
+        if (!colors_match(rule.first, color))
+            continue;
+        const auto &replacement = rule.second;
+        std::string out;
+        for (double component : replacement) {
+            out += format_number(component);
+            out += ' ';
+        }
+        const char *fill_ops[]   = {"", "g", "", "rg", "k"};
+        const char *stroke_ops[] = {"", "G", "", "RG", "K"};
+        out += stroke ? stroke_ops[replacement.size()] : fill_ops[replacement.size()];
+        this->pending.clear();
+        this->write(out);
+        return true;
+    }
+    return false;
+}
+
+// Rename names that are direct operands, not keys or values inside arrays and
+// dictionaries, such as a marked content property list
+void ContentRules::renameResources()
+{
+    int depth = 0;
+    for (auto &token : this->pending) {
+        switch (token.getType()) {
+        case QPDFTokenizer::tt_array_open:
+        case QPDFTokenizer::tt_dict_open:
+            ++depth;
+            break;
+        case QPDFTokenizer::tt_array_close:
+        case QPDFTokenizer::tt_dict_close:
+            --depth;
+            break;
+        case QPDFTokenizer::tt_name:
+            if (depth == 0) {
+                auto found = this->rules->rename_resources.find(token.getValue());
+                if (found != this->rules->rename_resources.end()) {
+                    auto name = QPDFObjectHandle::newName(found->second);
+                    token     = Token(QPDFTokenizer::tt_name, name.unparse());
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+std::vector<const ContentRules::Token *> ContentRules::operands() const
+{
+    std::vector<const Token *> result;
+    for (const auto &token : this->pending) {
+        auto type = token.getType();
+        if (type != QPDFTokenizer::tt_space && type != QPDFTokenizer::tt_comment)
+            result.push_back(&token);
+    }
+    return result;
+}
+
+void ContentRules::flushPending()
+{
+    for (const auto &token : this->pending)
+        this->writeToken(token);
+    this->pending.clear();
+}
+
+static std::string name_or_str(py::handle h, const char *what)
+{
+    std::string value;
+    if (py::isinstance<py::str>(h)) {
+        value = h.cast<std::string>();
+    } else {
+        auto obj = h.cast<QPDFObjectHandle>();
+        if (!obj.isName())
+            throw py::type_error(std::string(what) + " must be pikepdf.Name or str");
+        value = obj.getName();
+    }
+    if (value.empty() || value[0] != '/')
+        throw py::value_error(std::string(what) + " must begin with '/'");
+    return value;
+}
+
+static std::vector<double> color_components(py::handle h)
+{
+    auto color = h.cast<std::vector<double>>();
+    if (color.size() != 1 && color.size() != 3 && color.size() != 4)
+        throw py::value_error(
+            "colors must have 1 (gray), 3 (RGB) or 4 (CMYK) components");
+    return color;
+}
+
 void init_tokenfilter(py::module_ &m)
 {
     py::enum_<QPDFTokenizer::token_type_e>(m, "TokenType")
@@ -141,4 +398,74 @@ void init_tokenfilter(py::module_ &m)
                     None or list or pikepdf.Token
             )~~~",
             py::arg_v("token", QPDFTokenizer::Token(), "pikepdf.Token()"));
+
+    py::class_<ContentRules, PointerHolder<ContentRules>>(
+        m, "ContentRules", qpdftokenfilter)
+        .def(py::init([](py::iterable drop_operators,
+                          py::dict rename_resources,
+                          py::dict replace_colors,
+                          bool strip_text) {
+            auto rules = std::make_shared<ContentRuleSet>();
+            for (auto op : drop_operators) {
+                if (py::isinstance<py::str>(op)) {
+                    rules->drop_operators.insert(op.cast<std::string>());
+                } else {
+                    auto obj = op.cast<QPDFObjectHandle>();
+                    if (!obj.isOperator())
+                        throw py::type_error(
+                            "drop_operators must contain pikepdf.Operator or str");
+                    rules->drop_operators.insert(obj.getOperatorValue());
+                }
+            }
+            for (auto item : rename_resources)
+                rules->rename_resources[name_or_str(item.first, "resource names")] =
+                    name_or_str(item.second, "resource names");
+            for (auto item : replace_colors)
+                rules->replace_colors.emplace_back(
+                    color_components(item.first), color_components(item.second));
+            rules->strip_text = strip_text;
+            return PointerHolder<ContentRules>(new ContentRules(std::move(rules)));
+        }),
+            py::kw_only(),
+            py::arg("drop_operators")   = py::tuple(),
+            py::arg("rename_resources") = py::dict(),
+            py::arg("replace_colors")   = py::dict(),
+            py::arg("strip_text")       = false,
+            R"~~~(
+                A set of content stream rewriting rules that run entirely in C++.
+
+                ``ContentRules`` may be used anywhere a :class:`pikepdf.TokenFilter`
+                can, such as :meth:`pikepdf.Page.add_content_token_filter` and
+                :meth:`pikepdf.Page.get_filtered_contents`. Because it never calls
+                Python code for each token, it is much faster than an equivalent
+                ``TokenFilter`` subclass on large content streams. Use a
+                ``TokenFilter`` for anything these rules cannot express.
+
+                Args:
+                    drop_operators: Operators to remove, together with their
+                        operands. Include ``'BI'`` to remove inline images.
+                    rename_resources: Mapping of resource names to replace in the
+                        operands of operators that refer to resources, such as
+                        ``Do``, ``Tf``, ``gs``, ``cs`` and ``BDC``. Keys and
+                        values are :class:`pikepdf.Name` or ``str`` such as
+                        ``'/Im0'``.
+                    replace_colors: Mapping of device colors to replace in the
+                        ``g``, ``rg`` and ``k`` operators and their stroking
+                        equivalents. Each color is a tuple of 1 (gray), 3 (RGB)
+                        or 4 (CMYK) numbers from 0 to 1. The replacement may use a
+                        different color space, and the operator changes to match.
+                    strip_text: If True, remove the text showing operators
+                        ``Tj``, ``TJ``, ``'`` and ``"``, keeping the line and
+                        spacing changes made by ``'`` and ``"``.
+
+                Example:
+
+                    >>> rules = pikepdf.ContentRules(
+                    ...     rename_resources={'/Im0': '/Im1'},
+                    ...     replace_colors={(1, 0, 0): (0,)},
+                    ... )
+                    >>> page.add_content_token_filter(rules)
+
+                .. versionadded:: 3.0
+            )~~~");
 }
@@ -0,0 +1,68 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (C) 2021, James R. Barlow (https://github.com/jbarlow83/)
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pikepdf.h"
+
+#include <qpdf/QPDFObjectHandle.hh>
+#include <qpdf/QPDFTokenizer.hh>
+
+// The rules of a pikepdf.ContentRules. They never change after construction, so
+// one set may be shared by filters running on several threads.
+struct ContentRuleSet {
+    std::set<std::string> drop_operators;
+    std::map<std::string, std::string> rename_resources;
+    std::vector<std::pair<std::vector<double>, std::vector<double>>> replace_colors;
+    bool strip_text = false;
+};
+
+// A token filter that applies a ContentRuleSet entirely in C++, so it never calls
+// into Python and can run while saving without the GIL. Tokens are buffered until
+// the operator that ends each instruction, then the instruction is written
+// unchanged, rewritten or dropped.
+class ContentRules : public QPDFObjectHandle::TokenFilter {
+public:
+    using Token = QPDFTokenizer::Token;
+
+    explicit ContentRules(std::shared_ptr<const ContentRuleSet> rules)
+        : rules(std::move(rules))
+    {
+    }
+    virtual ~ContentRules() = default;
+
+    void handleToken(Token const &token) override;
+    void handleEOF() override;
+
+    std::shared_ptr<const ContentRuleSet> rule_set() const { return this->rules; }
+
+    // Apply rules to a complete, decoded content stream. Does not need the GIL.
+    static std::string apply(
+        std::shared_ptr<const ContentRuleSet> rules, const std::string &content);
+
+    static bool is_resource_operator(const std::string &op);
+
+private:
+    void handleOperator(Token const &op_token);
+    bool stripTextOperator(const std::string &op);
+    bool replaceColor(const std::string &op);
+    void renameResources();
+    std::vector<const Token *> operands() const;
+    void flushPending();
+
+    std::shared_ptr<const ContentRuleSet> rules;
+    std::vector<Token> pending;
+    bool in_inline_image = false;
+};
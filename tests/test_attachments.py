@@ -79,6 +79,43 @@ def test_filespec_types(pal, resources):
         fs_path.get_file(pikepdf.Array([1]))
 
 
+def test_attachment_open_reader(pal, resources):
+    some_path = resources / 'rle.pdf'
+    fs = AttachedFileSpec.from_filepath(pal, some_path)
+    with fs.get_file().open_reader(chunk_size=1000, spool_size=2000) as reader:
+        chunks = list(reader)
+    assert b''.join(chunks) == some_path.read_bytes()
+    assert all(len(chunk) == 1000 for chunk in chunks[:-1])
+
+
+def test_attachment_from_filepath_reads_now(pal, outdir, outpdf):
+    path = outdir / 'eager.txt'
+    path.write_bytes(b'read immediately')
+    pal.attachments['eager.txt'] = AttachedFileSpec.from_filepath(pal, path)
+    path.unlink()
+    pal.save(outpdf)
+
+    with Pdf.open(outpdf) as output:
+        assert (
+            output.attachments['eager.txt'].get_file().read_bytes()
+            == b'read immediately'
+        )
+
+
+def test_attachment_from_filepath_is_lazy(pal, outdir, outpdf):
+    data = b'attached lazily\n' * 10000
+    path = outdir / 'lazy.txt'
+    path.write_bytes(data)
+    fs = AttachedFileSpec.from_filepath(pal, path, lazy=True)
+    assert fs.get_file().size == len(data)
+    assert fs.get_file().md5 == md5(data).digest()
+    pal.attachments['lazy.txt'] = fs
+    pal.save(outpdf)
+
+    with Pdf.open(outpdf) as output:
+        assert output.attachments['lazy.txt'].get_file().read_bytes() == data
+
+
 def test_attachment_metadata(pal):
     fs = AttachedFileSpec(pal, b'some data', description='test filespec')
     attached_stream = fs.get_file()
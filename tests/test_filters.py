@@ -1,6 +1,17 @@
 import pytest
 
-from pikepdf import Page, Pdf, PdfError, Token, TokenFilter, TokenType
+from pikepdf import (
+    ContentRules,
+    Name,
+    Operator,
+    Page,
+    Pdf,
+    PdfError,
+    Stream,
+    Token,
+    TokenFilter,
+    TokenType,
+)
 
 
 @pytest.fixture
@@ -119,3 +130,79 @@ def test_issue160_tokenfilter_refcounting(resources, outpdf):
             page.add_content_token_filter(f)
             num += 1
         pdf.save(outpdf)
+
+
+@pytest.mark.parametrize(
+    'kwargs, expected',
+    [
+        ({}, b'q\n144.0000 0 0 144.0000 0.0000 0.0000 cm\n/Im0 Do\nQ'),
+        (dict(drop_operators=['cm']), b'q\n\n/Im0 Do\nQ'),
+        (
+            dict(drop_operators=[Operator('Do')]),
+            b'q\n144.0000 0 0 144.0000 0.0000 0.0000 cm\n\nQ',
+        ),
+        (
+            dict(rename_resources={'/Im0': Name.Im1}),
+            b'q\n144.0000 0 0 144.0000 0.0000 0.0000 cm\n/Im1 Do\nQ',
+        ),
+    ],
+)
+def test_content_rules(pal, kwargs, expected):
+    page = pal.pages[0]
+    assert page.get_filtered_contents(ContentRules(**kwargs)) == expected
+
+
+def test_content_rules_saved(pal, outpdf):
+    page = pal.pages[0]
+    page.add_content_token_filter(ContentRules(drop_operators=['Do']))
+    pal.save(outpdf)
+    with Pdf.open(outpdf) as pdf:
+        assert b'Do' not in pdf.pages[0].obj.Contents.read_bytes()
+
+
+def _filtered(pdf, content, rules):
+    page = pdf.pages[0]
+    page.obj.Contents = Stream(pdf, content)
+    return page.get_filtered_contents(rules)
+
+
+def test_content_rules_colors(pal):
+    rules = ContentRules(replace_colors={(1, 0, 0): (0,), (0.5,): (0, 0, 0, 1)})
+    assert _filtered(pal, b'1 0 0 rg 1.0 0 0 RG 0 1 0 rg', rules) == (
+        b'0 g 0 G 0 1 0 rg'
+    )
+    assert _filtered(pal, b'.5 g 0.5000 G', rules) == b'0 0 0 1 k 0 0 0 1 K'
+
+
+def test_content_rules_rename_only_resources(pal):
+    rules = ContentRules(rename_resources={Name.F1: Name.F2, '/GS0': '/GS1'})
+    content = b'/GS0 gs BT /F1 12 Tf /Span <</F1 1>> BDC (F1) Tj EMC ET /F1 /GS0 d0'
+    assert _filtered(pal, content, rules) == (
+        b'/GS1 gs BT /F2 12 Tf /Span <</F1 1>> BDC (F1) Tj EMC ET /F1 /GS0 d0'
+    )
+
+
+def test_content_rules_strip_text(pal):
+    rules = ContentRules(strip_text=True)
+    content = b'BT /F1 12 Tf (a) Tj [(b) 5 (c)] TJ (d) \' 1 2 (e) " ET'
+    assert _filtered(pal, content, rules) == b'BT /F1 12 Tf   T* 1 Tw 2 Tc T* ET'
+
+
+def test_content_rules_inline_image(pal):
+    content = b'q BI /W 1 /H 1 /BPC 8 /CS /G ID \x00 EI Q'
+    assert _filtered(pal, content, ContentRules()) == content
+    assert _filtered(pal, content, ContentRules(drop_operators=['BI'])) == b'q  Q'
+
+
+@pytest.mark.parametrize(
+    'kwargs, exc',
+    [
+        (dict(drop_operators=[Name.Do]), TypeError),
+        (dict(rename_resources={'Im0': '/Im1'}), ValueError),
+        (dict(rename_resources={'/Im0': 1}), TypeError),
+        (dict(replace_colors={(1, 0): (0,)}), ValueError),
+    ],
+)
+def test_content_rules_invalid(kwargs, exc):
+    with pytest.raises(exc):
+        ContentRules(**kwargs)
@@ -191,8 +191,9 @@ def test_file_deny_mmap(resources, monkeypatch):
         raise IOError("This file is temporarily not mmap-able")
 
     monkeypatch.setattr(mmap, 'mmap', raises_ioerror)
-    with pytest.raises(IOError):
-        Pdf.open(resources / 'pal.pdf', access_mode=pikepdf._qpdf.AccessMode.mmap_only)
+    with open(resources / 'pal.pdf', 'rb') as f:
+        with pytest.raises(IOError):
+            Pdf.open(f, access_mode=pikepdf._qpdf.AccessMode.mmap_only)
 
     with Pdf.open(
         resources / 'pal.pdf', access_mode=pikepdf._qpdf.AccessMode.default
@@ -200,6 +201,48 @@ def test_file_deny_mmap(resources, monkeypatch):
         assert len(pdf.pages) == 1
 
 
+@pytest.mark.skipif(sys.platform == 'win32', reason="native mmap is POSIX only")
+def test_path_mmap_is_native(resources, monkeypatch):
+    import mmap
+
+    def raises_ioerror(*args, **kwargs):
+        raise AssertionError("paths should not be mapped with Python's mmap")
+
+    monkeypatch.setattr(mmap, 'mmap', raises_ioerror)
+    with Pdf.open(
+        resources / 'fourpages.pdf', access_mode=pikepdf._qpdf.AccessMode.mmap_only
+    ) as pdf:
+        assert len(pdf.pages) == 4
+        assert pdf.pages[3].Contents.read_bytes()
+
+
+@pytest.mark.parametrize('populate', [False, True])
+def test_mmap_populate(resources, populate):
+    initial = pikepdf._qpdf.get_mmap_populate()
+    try:
+        pikepdf._qpdf.set_mmap_populate(populate)
+        assert pikepdf._qpdf.get_mmap_populate() == populate
+        with Pdf.open(
+            resources / 'pal.pdf', access_mode=pikepdf._qpdf.AccessMode.mmap
+        ) as pdf:
+            assert len(pdf.pages) == 1
+    finally:
+        pikepdf._qpdf.set_mmap_populate(initial)
+
+
+def test_mmap_path_errors(resources, outdir):
+    with pytest.raises(FileNotFoundError):
+        Pdf.open(
+            outdir / 'missing.pdf', access_mode=pikepdf._qpdf.AccessMode.mmap_only
+        )
+
+    empty = outdir / 'empty.pdf'
+    empty.touch()
+    with pytest.raises(PdfError):
+        # Empty files can't be mapped, so this falls back to stream access
+        Pdf.open(empty, access_mode=pikepdf._qpdf.AccessMode.mmap)
+
+
 def test_mmap_only_file(resources):
     class UnreadableFile(FileIO):
         def readinto(self, *args):
@@ -258,3 +301,192 @@ def test_read_after_close(resources):
     pdf.close()
     with pytest.raises(PdfError, match="closed input source"):
         contents.read_raw_bytes()
+
+
+class CountingBytesIO(BytesIO):
+    def __init__(self):
+        super().__init__()
+        self.write_calls = 0
+
+    def write(self, b):
+        self.write_calls += 1
+        return super().write(b)
+
+
+@pytest.fixture
+def save_buffer_size():
+    saved = pikepdf._qpdf.get_save_buffer_size()
+    yield pikepdf._qpdf.set_save_buffer_size
+    pikepdf._qpdf.set_save_buffer_size(saved)
+
+
+def test_save_coalesces_writes(sandwich, save_buffer_size):
+    bio = BytesIO()
+    sandwich.save(bio, static_id=True)
+    expected = bio.getvalue()
+
+    cbio = CountingBytesIO()
+    sandwich.save(cbio, static_id=True)
+    assert cbio.getvalue() == expected
+    assert cbio.write_calls <= len(expected) // (1024 * 1024) + 1
+
+    save_buffer_size(4096)
+    cbio = CountingBytesIO()
+    sandwich.save(cbio, static_id=True)
+    assert cbio.getvalue() == expected
+    assert cbio.write_calls <= len(expected) // 4096 + 1
+
+    with pytest.raises(ValueError):
+        save_buffer_size(0)
+
+
+@pytest.mark.parametrize('buffering', [0, -1])
+def test_save_to_file_descriptor(sandwich, outdir, buffering):
+    bio = BytesIO()
+    sandwich.save(bio, static_id=True)
+    expected = bio.getvalue()
+
+    path = outdir / 'prefixed.pdf'
+    with open(path, 'wb', buffering=buffering) as f:
+        f.write(b'prefix')
+        sandwich.save(f, static_id=True)
+        assert f.tell() == len(b'prefix') + len(expected)
+        f.write(b'suffix')
+    assert path.read_bytes() == b'prefix' + expected + b'suffix'
+
+
+def test_save_to_file_like_with_fileno(sandwich, outdir):
+    import gzip
+
+    bio = BytesIO()
+    sandwich.save(bio, static_id=True)
+
+    # GzipFile has a fileno(), but must still be written through Python
+    path = outdir / 'out.pdf.gz'
+    with gzip.open(path, 'wb') as gz:
+        sandwich.save(gz, static_id=True)
+    assert gzip.decompress(path.read_bytes()) == bio.getvalue()
+
+
+class CountingReadBytesIO(BytesIO):
+    def __init__(self, data):
+        super().__init__(data)
+        self.read_calls = 0
+
+    def readinto(self, b):
+        self.read_calls += 1
+        return super().readinto(b)
+
+    def read(self, *args):
+        self.read_calls += 1
+        return super().read(*args)
+
+
+@pytest.fixture
+def read_cache_size():
+    saved = pikepdf._qpdf.get_read_cache_size()
+    yield pikepdf._qpdf.set_read_cache_size
+    pikepdf._qpdf.set_read_cache_size(*saved)
+
+
+def _count_reads_to_parse(data):
+    stream = CountingReadBytesIO(data)
+    with Pdf.open(stream) as pdf:
+        for obj in pdf.objects:
+            obj._type_code  # Resolve every object so it is parsed
+        info = pdf._read_cache_info
+    return stream.read_calls, info
+
+
+def test_read_cache_reduces_stream_calls(resources, read_cache_size):
+    data = (resources / 'sandwich.pdf').read_bytes()
+
+    cached_calls, info = _count_reads_to_parse(data)
+    assert info['hits'] > 10 * info['misses']
+    assert info['stream_reads'] <= cached_calls
+
+    # One byte blocks make roughly one stream call per read, like an uncached source
+    read_cache_size(1, 1)
+    uncached_calls, info = _count_reads_to_parse(data)
+    assert (info['block_size'], info['block_count']) == (1, 1)
+    assert cached_calls * 10 <= uncached_calls
+
+    with pytest.raises(ValueError):
+        read_cache_size(0, 16)
+
+
+def test_read_cache_info(resources):
+    with Pdf.open(
+        resources / 'pal.pdf', access_mode=pikepdf._qpdf.AccessMode.stream
+    ) as pdf:
+        assert pdf._read_cache_info['misses'] >= 1
+    with Pdf.open(
+        resources / 'pal.pdf', access_mode=pikepdf._qpdf.AccessMode.mmap_only
+    ) as pdf:
+        assert pdf._read_cache_info is None
+    assert Pdf.new()._read_cache_info is None
+
+
+def _save_bytes(pdf, **kwargs):
+    bio = BytesIO()
+    pdf.save(bio, static_id=True, **kwargs)
+    return bio.getvalue()
+
+
+def test_concurrent_saves(resources):
+    from concurrent.futures import ThreadPoolExecutor
+
+    names = ['sandwich.pdf', 'graph.pdf', 'congress.pdf', 'fourpages.pdf']
+    pdfs = [Pdf.open(resources / name) for name in names]
+    try:
+        expected = [_save_bytes(pdf, recompress_flate=True) for pdf in pdfs]
+        with ThreadPoolExecutor(max_workers=len(pdfs)) as executor:
+            for _ in range(3):
+                results = list(
+                    executor.map(
+                        lambda pdf: _save_bytes(pdf, recompress_flate=True), pdfs
+                    )
+                )
+                assert results == expected
+    finally:
+        for pdf in pdfs:
+            pdf.close()
+
+
+def test_concurrent_saves_same_pdf(sandwich, outdir):
+    from concurrent.futures import ThreadPoolExecutor
+
+    expected = _save_bytes(sandwich)
+    paths = [outdir / f'same{n}.pdf' for n in range(4)]
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        list(executor.map(lambda p: sandwich.save(p, static_id=True), paths))
+        results = list(executor.map(lambda _: _save_bytes(sandwich), range(4)))
+    assert all(path.read_bytes() == expected for path in paths)
+    assert all(result == expected for result in results)
+
+
+def test_read_during_save(resources, outdir):
+    from concurrent.futures import ThreadPoolExecutor
+
+    with Pdf.open(resources / 'fourpages.pdf') as pdf:
+        expected = [repr(page.MediaBox) for page in pdf.pages]
+        paths = [outdir / f'read{n}.pdf' for n in range(8)]
+        with ThreadPoolExecutor(max_workers=2) as executor:
+            saving = executor.submit(
+                lambda: [pdf.save(p, static_id=True, workers=2) for p in paths]
+            )
+            while not saving.done():
+                assert [repr(page.MediaBox) for page in pdf.pages] == expected
+            saving.result()
+        first = paths[0].read_bytes()
+        assert all(path.read_bytes() == first for path in paths)
+
+
+def test_close_during_save(resources):
+    with Pdf.open(resources / 'graph.pdf') as pdf:
+
+        def progress(_percent):
+            pdf.close()
+
+        with pytest.raises(ValueError, match="being saved"):
+            pdf.save(BytesIO(), progress=progress)
@@ -3,6 +3,7 @@ import sys
 from copy import copy
 from decimal import Decimal, InvalidOperation
 from distutils.version import LooseVersion
+from io import BytesIO
 from math import isclose, isfinite
 from typing import Type
 from zlib import compress
@@ -76,6 +77,52 @@ def test_binary_involution(binary_):
     assert bytes(encode(binary_)) == binary_
 
 
+def test_encode_subclasses_and_lookalikes():
+    from collections import OrderedDict
+    from enum import IntEnum
+
+    class Color(IntEnum):
+        RED = 1
+
+    class MyStr(str):
+        pass
+
+    class MyDecimal(Decimal):
+        pass
+
+    class MyList(list):
+        pass
+
+    assert encode(Color.RED) == 1
+    assert str(encode(MyStr('text'))) == 'text'
+    assert encode(MyDecimal('1.5')) == Decimal('1.5')
+    assert encode(MyList([1, 2])) == Array([1, 2])
+    assert encode((1, (2, 3))) == Array([1, Array([2, 3])])
+    assert encode(OrderedDict([('/A', 1), ('/B', 2)])) == Dictionary(A=1, B=2)
+    assert encode(range(3)) == Array([0, 1, 2])
+
+
+def test_encode_nested_mixed():
+    value = {
+        '/Array': [1, 2.5, Decimal('3.25'), True, None, 'str', b'bytes', Name.N],
+        '/Dict': {'/Inner': (Array([1]), Dictionary(X=1))},
+    }
+    encoded = encode(value)
+    assert encoded.Array == Array(
+        [1, 2.5, Decimal('3.25'), True, None, String('str'), b'bytes', Name.N]
+    )
+    assert encoded.Dict.Inner[1].X == 1
+    with pytest.raises(ValueError, match="NaN or Infinity"):
+        encode([1, float('nan')])
+    with pytest.raises(ValueError, match="NaN or Infinity"):
+        encode({'/X': Decimal('inf')})
+
+
+def test_encode_unknown_type():
+    with pytest.raises((RuntimeError, TypeError), match="don't know how to encode"):
+        encode([object()])
+
+
 int64s = integers(min_value=-9223372036854775807, max_value=9223372036854775807)
 
 
@@ -586,6 +633,65 @@ class TestStreamReadWrite:
             decode_parms=Dictionary(K=-1, Columns=8, Length=1),
         )
 
+    def test_stream_buffer(self, stream_object):
+        stream_object.write(compress(b'buffered'), filter=Name.FlateDecode)
+        buffer = stream_object.get_stream_buffer()
+        assert len(buffer) == len(b'buffered')
+        with memoryview(buffer) as mv:
+            assert mv.readonly
+            assert mv.tobytes() == b'buffered'
+            with pytest.raises(TypeError):
+                mv[0] = 0
+        with memoryview(stream_object.get_raw_stream_buffer()) as mv:
+            assert mv.readonly
+            assert mv.tobytes() == compress(b'buffered')
+
+    def test_stream_buffer_outlives_pdf(self):
+        pdf = pikepdf.new()
+        stream = Stream(pdf, b'still here')
+        buffer = stream.get_stream_buffer()
+        del stream
+        pdf.close()
+        del pdf
+        assert bytes(buffer) == b'still here'
+
+    def test_open_reader(self, stream_object):
+        data = bytes(range(256)) * 100
+        stream_object.write(compress(data), filter=Name.FlateDecode)
+        with stream_object.open_reader(chunk_size=1000, spool_size=4096) as reader:
+            assert reader.readable() and not reader.writable()
+            assert reader.read(10) == data[:10]
+            reader.seek(0)
+            chunks = list(reader)
+        assert reader.closed
+        assert b''.join(chunks) == data
+        assert [len(c) for c in chunks] == [1000] * 25 + [600]
+
+        with stream_object.open_reader(
+            decode_level=pikepdf.StreamDecodeLevel.none
+        ) as reader:
+            assert reader.read() == compress(data)
+
+        with pytest.raises(ValueError):
+            stream_object.open_reader(chunk_size=0)
+
+    def test_open_reader_unfilterable(self, stream_object):
+        stream_object.write(b'\x00', filter=Name.JBIG2Decode)
+        with pytest.raises(pikepdf.PdfError, match="unfilterable"):
+            stream_object.open_reader()
+        # Decodability is checked before any data is copied
+        out = BytesIO()
+        with pytest.raises(pikepdf.PdfError, match="unfilterable"):
+            stream_object._pipe_stream_data(out)
+        assert out.getvalue() == b''
+
+    def test_open_reader_corrupt(self, stream_object):
+        stream_object.write(b'this is not zlib data', filter=Name.FlateDecode)
+        with pytest.raises(pikepdf.PdfError, match="error decoding stream data"):
+            stream_object.open_reader()
+        with pytest.raises(pikepdf.PdfError, match="error decoding stream data"):
+            stream_object._pipe_stream_data(BytesIO())
+
     def test_stream_bytes(self, stream_object):
         stream_object.write(b'pi')
         assert bytes(stream_object) == b'pi'
@@ -608,6 +714,67 @@ class TestStreamReadWrite:
                 decode_parms=[Dictionary(), Dictionary()],
             )
 
+    def test_write_from_path(self, stream_object, tmp_path):
+        data = bytes(range(256)) * 5000
+        path = tmp_path / 'data.bin'
+        path.write_bytes(data)
+        stream_object.write_from(path)
+        assert stream_object.read_bytes() == data
+        # Read again to check the source is replayed
+        assert stream_object.read_bytes() == data
+        path.write_bytes(b'changed')
+        assert stream_object.read_bytes() == b'changed'
+
+    def test_write_from_file(self, stream_object):
+        f = BytesIO(b'skip' + compress(b'from a file'))
+        f.seek(4)
+        stream_object.write_from(f, filter=Name.FlateDecode)
+        assert stream_object.read_bytes() == b'from a file'
+        assert stream_object.read_bytes() == b'from a file'
+
+    def test_write_from_callable(self, stream_object):
+        calls = 0
+
+        def chunks():
+            nonlocal calls
+            calls += 1
+            yield b'abc'
+            yield bytearray(b'def')
+            yield memoryview(b'ghi')
+
+        stream_object.write_from(chunks)
+        assert calls == 0
+        assert stream_object.read_bytes() == b'abcdefghi'
+        assert stream_object.read_bytes() == b'abcdefghi'
+        assert calls == 2
+
+    def test_write_from_iterator_once(self, stream_object):
+        stream_object.write_from(iter([b'once', b'only']))
+        assert stream_object.read_bytes() == b'onceonly'
+        with pytest.raises(RuntimeError, match="only be read once"):
+            stream_object.read_bytes()
+
+    def test_write_from_bytes(self, stream_object):
+        with pytest.raises(TypeError, match="use write"):
+            stream_object.write_from(b'data')
+
+    def test_write_from_bad_chunk(self, stream_object):
+        stream_object.write_from(lambda: [b'ok', 42])
+        with pytest.raises(TypeError):
+            stream_object.read_bytes()
+
+    def test_write_from_save(self, tmp_path):
+        pdf = pikepdf.new()
+        path = tmp_path / 'data.bin'
+        path.write_bytes(b'saved lazily' * 1000)
+        stream = Stream(pdf, b'')
+        stream.write_from(path)
+        pdf.Root.LazyStream = stream
+        out = BytesIO()
+        pdf.save(out)
+        with pikepdf.open(out) as reopened:
+            assert reopened.Root.LazyStream.read_bytes() == b'saved lazily' * 1000
+
 
 def test_copy():
     d = Dictionary(
@@ -636,6 +803,163 @@ def test_object_iteration(sandwich):
     assert expected == loops
 
 
+def test_object_table(sandwich):
+    objects = sandwich.objects
+    n = len(objects)
+    assert list(objects[-2:]) == [objects[n - 2], objects[n - 1]]
+    with pytest.raises(IndexError):
+        objects[n]
+    assert repr(objects) == f'<pikepdf._qpdf._ObjectTable len={n}>'
+
+
+def test_object_table_iterator(sandwich):
+    it = iter(sandwich.objects)
+    next(it)
+    assert iter(it) is it
+    assert len(list(iter(it))) == len(sandwich.objects) - 1
+
+
+def test_object_table_repr_does_not_count(sandwich):
+    # Counting created objects would read the whole file
+    objects = sandwich.objects
+    assert repr(objects).startswith('<pikepdf._qpdf._ObjectTable len>=')
+
+
+def test_object_table_includes_new_objects(sandwich):
+    before = len(sandwich.objects)
+    new = sandwich.make_indirect(Dictionary(Type=Name('/Test')))
+    objects = sandwich.objects
+    assert len(objects) == before + 1
+    assert objects[-1].objgen == new.objgen
+    assert list(objects)[-1].objgen == new.objgen
+
+
+def test_object_table_of_type(sandwich):
+    streams = sandwich.objects.of_type(pikepdf.ObjectType.stream)
+    expected = [obj for obj in sandwich.objects if isinstance(obj, Stream)]
+    assert [s.objgen for s in streams] == [s.objgen for s in expected]
+    dicts = sandwich.objects.of_type(pikepdf.ObjectType.dictionary)
+    assert all(isinstance(d, Dictionary) for d in dicts)
+
+
+def test_find_objects(sandwich):
+    images = sandwich.find_objects(type=Name.XObject, subtype='/Image')
+    expected = [
+        obj
+        for obj in sandwich.objects
+        if isinstance(obj, Stream)
+        and obj.get('/Type') == Name.XObject
+        and obj.get('/Subtype') == Name.Image
+    ]
+    assert images
+    assert [im.objgen for im in images] == [im.objgen for im in expected]
+
+    pages = sandwich.find_objects(type=Name.Page, has_key=['/MediaBox', Name.Parent])
+    assert [p.objgen for p in pages] == [p.obj.objgen for p in sandwich.pages]
+    assert sandwich.find_objects(has_key='/NoSuchKey') == []
+
+
+def test_find_objects_filter(sandwich):
+    image = next(iter(sandwich.pages[0].images.values()))
+    found = sandwich.find_objects(filter=Name.CCITTFaxDecode)
+    assert [obj.objgen for obj in found] == [image.objgen]
+    assert sandwich.find_objects(filter='/DCTDecode') == []
+
+
+def test_find_objects_bad_name(sandwich):
+    with pytest.raises(ValueError):
+        sandwich.find_objects(type='XObject')
+
+
+class TestContentDigest:
+    def test_equal_values(self):
+        assert Array([1, 2.0, 'a']).content_digest() == (
+            Array([1.0, Decimal('2.000'), String('a')]).content_digest()
+        )
+        assert Dictionary(A=1, B=2).content_digest() == (
+            Dictionary(B=2, A=1).content_digest()
+        )
+        assert Array([1]).content_digest() != Array([1, 1]).content_digest()
+        assert Array([Name.A]).content_digest() != Array(['/A']).content_digest()
+        assert len(Dictionary().content_digest()) == 32
+
+    def test_indirect_objects_by_content(self):
+        pdf = Pdf.new()
+        a = pdf.make_indirect(Dictionary(Leaf=True))
+        b = pdf.make_indirect(Dictionary(Leaf=True))
+        assert a.objgen != b.objgen
+        assert Array([a]).content_digest() == Array([b]).content_digest()
+
+        other = Pdf.new()
+        c = other.make_indirect(Dictionary(Leaf=True))
+        assert a.content_digest() == c.content_digest()
+
+    def test_cycles(self):
+        pdf = Pdf.new()
+        a = pdf.make_indirect(Dictionary())
+        b = pdf.make_indirect(Dictionary())
+        a.Next = b
+        b.Next = a
+        assert a.content_digest() == b.content_digest()
+        a.Extra = 1
+        assert a.content_digest() != b.content_digest()
+
+    def test_outline_cycles(self):
+        pdf = Pdf.new()
+        outlines = pdf.make_indirect(Dictionary(Type=Name.Outlines))
+        pdf.Root.Outlines = outlines
+
+        def add_children(parent, count, depth):
+            children = [
+                pdf.make_indirect(Dictionary(Title=f'{depth}.{n}', Parent=parent))
+                for n in range(count)
+            ]
+            for prev, next_ in zip(children, children[1:]):
+                prev.Next = next_
+                next_.Prev = prev
+            parent.First = children[0]
+            parent.Last = children[-1]
+            parent.Count = count
+            return children
+
+        top = add_children(outlines, 1200, 0)
+        for node in top[::100]:
+            for child in add_children(node, 5, 1):
+                add_children(child, 3, 2)
+
+        digest = pdf.Root.content_digest()
+        assert len(digest) == 32
+        assert top[0].content_digest() != top[1].content_digest()
+        assert top[0].content_digest() == top[0].content_digest(cache=True)
+        top[-1].Title = 'changed'
+        assert pdf.Root.content_digest() != digest
+
+    def test_streams(self):
+        pdf = Pdf.new()
+        plain = Stream(pdf, b'abcxyz')
+        compressed = Stream(pdf, compress(b'abcxyz'), Filter=Name.FlateDecode)
+        assert plain.content_digest() != compressed.content_digest()
+        assert plain.content_digest(decode=True) == (
+            compressed.content_digest(decode=True)
+        )
+
+    def test_cache(self):
+        pdf = Pdf.new()
+        a = pdf.make_indirect(Dictionary(Value=1))
+        before = a.content_digest(cache=True)
+        a.Value = 2
+        assert a.content_digest(cache=True) == before
+        assert a.content_digest() != before
+        pdf.clear_digest_cache()
+        assert a.content_digest(cache=True) != before
+
+    def test_pages(self, resources):
+        with Pdf.open(resources / 'fourpages.pdf') as pdf:
+            page = pdf.pages[0].obj
+            assert page.content_digest(cache=True) == page.content_digest()
+            assert page.content_digest(decode=True) == page.content_digest(decode=True)
+
+
 def test_object_not_iterable():
     with pytest.raises(TypeError, match="__iter__ not available"):
         iter(pikepdf.Name.A)
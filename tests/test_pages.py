@@ -1,6 +1,8 @@
 import gc
 from contextlib import suppress
+from io import BytesIO
 from shutil import copy
+from time import perf_counter
 from typing import Type, ValuesView
 
 try:
@@ -13,12 +15,15 @@ from conftest import skip_if_pypy
 
 from pikepdf import (
     Array,
+    ContentRules,
     Dictionary,
     Name,
     Page,
     Pdf,
     PdfMatrix,
     Stream,
+    String,
+    TokenFilter,
     __libqpdf_version__,
 )
 from pikepdf._cpphelpers import label_from_label_dict
@@ -542,3 +547,352 @@ def test_page_from_objgen(graph):
     )
     with pytest.raises(ValueError):
         graph.pages.from_objgen(graph.pages[0].Contents.objgen)
+
+
+def _make_pdf_with_pages(npages):
+    pdf = Pdf.new()
+    pdf.add_blank_page()
+    while len(pdf.pages) < npages:
+        pdf.pages.extend(pdf.pages[: npages - len(pdf.pages)])
+    return pdf
+
+
+def _best_iteration_time(pdf, repeats=3):
+    best = float('inf')
+    for _ in range(repeats):
+        start = perf_counter()
+        for _page in pdf.pages:
+            pass
+        best = min(best, perf_counter() - start)
+    return best
+
+
+@pytest.mark.timeout(60)
+def test_page_iteration_scales_linearly():
+    small, large = _make_pdf_with_pages(1000), _make_pdf_with_pages(16000)
+    assert len(large.pages) == 16000
+    t_small = _best_iteration_time(small)
+    t_large = _best_iteration_time(large)
+    # 16x more pages should cost ~16x more time; O(n^2) would be ~256x.
+    assert t_large < max(t_small, 1e-4) * 64
+
+
+def test_page_access_after_insert_delete(fourpages, sandwich):
+    pages = fourpages.pages
+    first = pages[0]
+    pages.insert(1, sandwich.pages[0])
+    assert len(pages) == 5
+    assert pages[0] == first
+    assert pages[1].objgen != first.objgen
+    del pages[1]
+    assert len(pages) == 4
+    assert [p.objgen for p in pages] == [p.objgen for p in pages[:]]
+    assert [p.objgen for p in pages[::-1]] == [p.objgen for p in reversed(list(pages))]
+
+
+def test_page_index_tracks_mutations(fourpages, sandwich):
+    pages = fourpages.pages
+    assert [p.index for p in pages] == [0, 1, 2, 3]
+    fourpages.add_blank_page()
+    assert pages[-1].index == 4
+    pages.append(sandwich.pages[0])
+    assert pages[-1].index == 5
+    del pages[-1]
+    fourpages._remove_page(pages[0].obj)
+    fourpages._add_page_at(sandwich.pages[0].obj, True, pages[2].obj)
+    for n, page in enumerate(pages):
+        assert page.index == n
+        assert pages.index(page) == n
+
+
+@pytest.mark.timeout(60)
+def test_page_index_scales_linearly():
+    pdf = _make_pdf_with_pages(16000)
+    start = perf_counter()
+    for n, page in enumerate(pdf.pages):
+        assert page.index == n
+    elapsed_indexed = perf_counter() - start
+    start = perf_counter()
+    for page in pdf.pages:
+        pass
+    elapsed_plain = perf_counter() - start
+    # Looking up each page's index should cost about as much as fetching the page
+    assert elapsed_indexed < max(elapsed_plain, 1e-4) * 20
+
+
+def test_map_native_content_rules(fourpages):
+    rules = ContentRules(drop_operators=['re'], strip_text=True)
+    expected = [page.get_filtered_contents(rules) for page in fourpages.pages]
+    fourpages.pages.map_native(rules, workers=3)
+    assert [page.obj.Contents.read_bytes() for page in fourpages.pages] == expected
+
+
+def test_map_native_coalesce(graph):
+    page = graph.pages[0]
+    original = page.obj.Contents.read_bytes()
+    page.contents_add(b'q Q', prepend=False)
+    assert isinstance(page.obj.Contents, Array)
+    graph.pages.map_native('coalesce')
+    assert isinstance(page.obj.Contents, Stream)
+    coalesced = page.obj.Contents.read_bytes()
+    assert coalesced.startswith(original.rstrip())
+    assert coalesced.rstrip().endswith(b'\nq Q')
+
+
+def test_map_native_python_stream_and_filter(resources):
+    class CountTokens(TokenFilter):
+        def __init__(self):
+            super().__init__()
+            self.count = 0
+
+        def handle_token(self, token):
+            self.count += 1
+            return token
+
+    data = BytesIO((resources / 'fourpages.pdf').read_bytes())
+    with Pdf.open(data) as pdf:
+        counter = CountTokens()
+        pdf.pages[0].add_content_token_filter(counter)
+        pdf.pages.map_native('coalesce', workers=2)
+        assert counter.count > 0
+        assert len(pdf.pages) == 4
+        assert all(page.obj.Contents.read_bytes() for page in pdf.pages)
+
+
+def test_map_native_remove_unreferenced_resources():
+    pdf = Pdf.new()
+    image = Stream(pdf, b'\xff', Type=Name.XObject, Subtype=Name.Image)
+    resources = pdf.make_indirect(
+        Dictionary(XObject=Dictionary(Im0=image, Im1=image, Im2=image))
+    )
+    for content in (b'/Im0 Do', b'/Im2 Do'):
+        page = pdf.add_blank_page()
+        page.obj.Resources = resources
+        page.obj.Contents = Stream(pdf, content)
+
+    rename = ContentRules(rename_resources={'/Im2': '/Im1'})
+    pdf.pages.map_native([rename, 'remove_unreferenced_resources'], workers=2)
+    assert set(pdf.pages[0].Resources.XObject.keys()) == {'/Im0'}
+    assert set(pdf.pages[1].Resources.XObject.keys()) == {'/Im1'}
+    assert pdf.pages[1].Contents.read_bytes() == b'/Im1 Do'
+    # The shared resource dictionary itself is unchanged
+    assert len(resources.XObject) == 3
+
+
+@pytest.mark.parametrize(
+    'op, exc',
+    [('nonsense', ValueError), (42, TypeError), (['coalesce', None], TypeError)],
+)
+def test_map_native_invalid(fourpages, op, exc):
+    with pytest.raises(exc):
+        fourpages.pages.map_native(op)
+
+
+def test_map_native_workers(fourpages):
+    with pytest.raises(ValueError):
+        fourpages.pages.map_native('coalesce', workers=0)
+
+
+def test_merge_paths_and_pdfs(resources, fourpages):
+    with Pdf.new() as pdf:
+        added = pdf.merge(
+            [resources / 'graph.pdf', fourpages, str(resources / 'sandwich.pdf')],
+            workers=2,
+        )
+        assert added == 6
+        assert len(pdf.pages) == 6
+        assert pdf.Root.Pages.Count == 6
+        for page in pdf.pages:
+            assert page.Parent == pdf.Root.Pages
+        assert pdf.pages[1].MediaBox == fourpages.pages[0].MediaBox
+        assert pdf.pages[5].index == 5
+
+
+def test_merge_matches_extend(resources, outpdf):
+    paths = [resources / 'fourpages.pdf', resources / 'graph.pdf'] * 3
+    sources = [Pdf.open(path) for path in paths]
+    with Pdf.new() as merged, Pdf.new() as extended:
+        merged.merge(paths, workers=3)
+        for src in sources:
+            extended.pages.extend(src.pages)
+        assert len(merged.pages) == len(extended.pages) == 15
+        for a, b in zip(merged.pages, extended.pages):
+            assert a.Contents.content_digest(decode=True) == b.Contents.content_digest(
+                decode=True
+            )
+        merged.save(outpdf)
+    for src in sources:
+        src.close()
+    with Pdf.open(outpdf) as pdf:
+        assert len(pdf.pages) == 15
+
+
+def test_merge_after_existing_pages(fourpages, resources, outpdf):
+    fourpages.merge([resources / 'graph.pdf'])
+    assert len(fourpages.pages) == 5
+    fourpages.pages.append(fourpages.pages[0])
+    assert len(fourpages.pages) == 6
+    fourpages.save(outpdf)
+    with Pdf.open(outpdf) as pdf:
+        assert len(pdf.pages) == 6
+
+
+def test_merge_same_pdf_twice(resources, outpdf):
+    with Pdf.open(resources / 'fourpages.pdf') as src, Pdf.new() as pdf:
+        pdf.pages.extend(src.pages)
+        assert pdf.merge([src, src]) == 8
+        assert len(pdf.pages) == 12
+        assert len({page.objgen for page in pdf.pages}) == 12
+        assert pdf.pages[4].Contents.objgen == pdf.pages[8].Contents.objgen
+        pdf.save(outpdf)
+    with Pdf.open(outpdf) as pdf:
+        assert len(pdf.pages) == 12
+
+
+def test_merge_closes_small_sources(resources, outdir):
+    source = outdir / 'source.pdf'
+    copy(resources / 'graph.pdf', source)
+    with Pdf.open(resources / 'graph.pdf') as original, Pdf.new() as pdf:
+        pdf.merge([source])
+        # The stream data was copied, so the file is no longer needed
+        source.write_bytes(b'\0' * source.stat().st_size)
+        pdf.save(outdir / 'merged.pdf')
+        with Pdf.open(outdir / 'merged.pdf') as merged:
+            assert (
+                merged.pages[0].Contents.read_bytes()
+                == original.pages[0].Contents.read_bytes()
+            )
+
+
+def test_merge_missing_source(fourpages, resources, outdir):
+    with pytest.raises(FileNotFoundError):
+        fourpages.merge([resources / 'graph.pdf', outdir / 'missing.pdf'])
+    assert len(fourpages.pages) == 4
+
+
+def test_merge_invalid(fourpages, resources):
+    with pytest.raises(ValueError):
+        fourpages.merge([fourpages])
+    with pytest.raises(ValueError):
+        fourpages.merge([resources / 'graph.pdf'], workers=0)
+    assert fourpages.merge([]) == 0
+
+
+def _make_invoice(path):
+    with Pdf.new() as pdf:
+        font = pdf.make_indirect(
+            Dictionary(
+                Type=Name.Font,
+                Subtype=Name.Type1,
+                BaseFont=Name.Helvetica,
+                FontDescriptor=Dictionary(
+                    FontFile=pdf.make_stream(b'font program' * 100)
+                ),
+            )
+        )
+        logo = pdf.make_stream(
+            b'\x80' * 3000,
+            Type=Name.XObject,
+            Subtype=Name.Image,
+            Width=100,
+            Height=10,
+            ColorSpace=Name.DeviceRGB,
+            BitsPerComponent=8,
+        )
+        for _ in range(2):
+            page = pdf.add_blank_page()
+            page.Resources = Dictionary(
+                Font=Dictionary(F1=font), XObject=Dictionary(Im0=logo)
+            )
+            page.Contents = pdf.make_stream(b'/Im0 Do BT /F1 12 Tf (Total) Tj ET')
+        pdf.save(path)
+
+
+def test_deduplicate_merged(outdir):
+    paths = []
+    for n in range(3):
+        paths.append(outdir / f'invoice{n}.pdf')
+        _make_invoice(paths[-1])
+
+    with Pdf.new() as pdf:
+        pdf.merge(paths)
+        pdf.save(outdir / 'before.pdf')
+        fonts = {page.Resources.Font.F1.objgen for page in pdf.pages}
+        assert len(fonts) == 3
+
+        saved = pdf.deduplicate()
+        assert saved > 0
+        fonts = {page.Resources.Font.F1.objgen for page in pdf.pages}
+        logos = {page.Resources.XObject.Im0.objgen for page in pdf.pages}
+        assert len(fonts) == len(logos) == 1
+        assert pdf.deduplicate() == 0
+
+        pdf.save(outdir / 'after.pdf')
+    before = (outdir / 'before.pdf').stat().st_size
+    after = (outdir / 'after.pdf').stat().st_size
+    assert after < before
+    with Pdf.open(outdir / 'after.pdf') as pdf:
+        assert len(pdf.pages) == 6
+        assert pdf.pages[5].Resources.XObject.Im0.read_bytes() == b'\x80' * 3000
+
+
+def test_deduplicate_keeps_distinct(fourpages, outpdf):
+    font1 = fourpages.make_indirect(Dictionary(Type=Name.Font, BaseFont=Name.A))
+    font2 = fourpages.make_indirect(Dictionary(Type=Name.Font, BaseFont=Name.B))
+    fourpages.pages[0].Resources = Dictionary(Font=Dictionary(F1=font1))
+    fourpages.pages[1].Resources = Dictionary(Font=Dictionary(F1=font2))
+    fourpages.save(outpdf, deduplicate=True)
+    assert fourpages.pages[0].Resources.Font.F1.BaseFont == Name.A
+    assert fourpages.pages[1].Resources.Font.F1.BaseFont == Name.B
+
+
+def test_deduplicate_keeps_layers(fourpages):
+    layers = [
+        fourpages.make_indirect(Dictionary(Type=Name.OCG, Name='Layer'))
+        for _ in range(2)
+    ]
+    for page, layer in zip(fourpages.pages, layers):
+        form = fourpages.make_stream(
+            b'0 0 m 10 10 l S',
+            Type=Name.XObject,
+            Subtype=Name.Form,
+            BBox=[0, 0, 10, 10],
+            OC=layer,
+        )
+        page.Resources = Dictionary(
+            XObject=Dictionary(Fm0=form), Properties=Dictionary(MC0=layer)
+        )
+    fourpages.deduplicate()
+    assert fourpages.pages[0].Resources.Properties.MC0.objgen == layers[0].objgen
+    assert fourpages.pages[1].Resources.Properties.MC0.objgen == layers[1].objgen
+    assert fourpages.pages[1].Resources.XObject.Fm0.OC.objgen == layers[1].objgen
+
+
+def test_deduplicate_keeps_palettes_apart(fourpages):
+    # These bytes have no PDFDocEncoding text, so they decode to the same text
+    lookups = [b'\x7f\x00\x00', b'\x9f\x00\x00', b'\xad\x00\x00']
+    palettes = [
+        fourpages.make_indirect(
+            Array([Name.Indexed, Name.DeviceRGB, 0, String(lookup)])
+        )
+        for lookup in lookups
+    ]
+    for page, palette in zip(fourpages.pages, palettes):
+        page.Resources = Dictionary(ColorSpace=Dictionary(CS0=palette))
+    assert fourpages.deduplicate() == 0
+    for page, lookup in zip(fourpages.pages, lookups):
+        assert bytes(page.Resources.ColorSpace.CS0[3]) == lookup
+
+
+def test_deduplicate_after_checking_options(fourpages):
+    fonts = [
+        fourpages.make_indirect(Dictionary(Type=Name.Font, BaseFont=Name.A))
+        for _ in range(2)
+    ]
+    for page, font in zip(fourpages.pages, fonts):
+        page.Resources = Dictionary(Font=Dictionary(F1=font))
+    with pytest.raises(ValueError):
+        fourpages.save(BytesIO(), deduplicate=True, workers=0)
+    with pytest.raises(ValueError):
+        fourpages.save(BytesIO(), deduplicate=True, incremental=True, qdf=True)
+    assert fourpages.pages[1].Resources.Font.F1.objgen == fonts[1].objgen
@@ -1,5 +1,6 @@
 import shutil
 import sys
+from decimal import Decimal
 from subprocess import PIPE, run
 
 import pytest
@@ -189,6 +190,91 @@ def test_parse_xobject(resources):
     assert instructions[0][1] == Operator('cm')
 
 
+class TestParsedContentStream:
+    @pytest.fixture
+    def congress(self, resources):
+        with Pdf.open(resources / 'congress.pdf') as pdf:
+            yield pdf
+
+    def test_list_like(self, congress):
+        instructions = parse_content_stream(congress.pages[0])
+        as_list = list(instructions)
+        assert len(instructions) == len(as_list) > 1
+        assert instructions == as_list
+        assert instructions[-1] == as_list[-1]
+        assert instructions[1:] == as_list[1:]
+        assert [op for _, op in instructions] == [op for _, op in as_list]
+        with pytest.raises(IndexError):
+            instructions[len(as_list)]
+
+    def test_instructions_created_once(self, congress):
+        instructions = parse_content_stream(congress.pages[0])
+        assert instructions[1] is instructions[1]
+        instructions[1][0][0] = Name.Foo
+        assert instructions[1][0][0] == Name.Foo
+        assert b'/Foo 0 0 304' in unparse_content_stream(instructions)
+
+    def test_mutation(self, congress):
+        instructions = parse_content_stream(congress.pages[0])
+        n = len(instructions)
+        last = instructions[-1]
+        instructions.append(([], Operator('q')))
+        assert len(instructions) == n + 1
+        assert instructions[n - 1] == last
+        instructions.insert(0, ([], Operator('Q')))
+        del instructions[1]
+        assert instructions[0] == ([], Operator('Q'))
+        assert instructions[-1] == ([], Operator('q'))
+        assert len(instructions) == n + 1
+        instructions[0] = ([], Operator('n'))
+        assert instructions[0][1] == Operator('n')
+
+    def test_whitelist(self, congress):
+        everything = parse_content_stream(congress.pages[0])
+        only_cm = parse_content_stream(congress.pages[0], 'cm')
+        assert list(only_cm) == [inst for inst in everything if inst[1] == 'cm']
+
+    def test_inline_image_operands(self, resources):
+        with Pdf.open(resources / 'image-mono-inline.pdf') as pdf:
+            instructions = parse_content_stream(pdf.pages[0])
+            inline = [inst for inst in instructions if inst[1] == 'INLINE IMAGE']
+            assert len(inline) == 1
+            assert isinstance(inline[0][0][0], PdfInlineImage)
+
+
+@pytest.mark.parametrize(
+    'filename',
+    [
+        'congress.pdf',
+        'image-mono-inline.pdf',
+        'veraPDF test suite 6-2-10-t02-pass-a.pdf',
+        'graph.pdf',
+    ],
+)
+def test_unparse_native_matches_materialized(resources, filename):
+    with Pdf.open(resources / filename) as pdf:
+        for page in pdf.pages:
+            native = unparse_content_stream(parse_content_stream(page))
+            materialized = unparse_content_stream(list(parse_content_stream(page)))
+            assert native == materialized
+
+            partial = parse_content_stream(page)
+            if len(partial):
+                partial[len(partial) // 2]  # Create just one instruction
+            assert unparse_content_stream(partial) == native
+
+
+def test_unparse_operand_formatting():
+    instructions = [
+        ([1, -2, 3.5, Decimal('0.25'), True, None], Operator('Tj')),
+        ([Name('/A#20B'), Name.Plain, pikepdf.String('(paren)')], Operator('Do')),
+    ]
+    assert unparse_content_stream(instructions) == slow_unparse_content_stream(
+        instructions
+    )
+    assert unparse_content_stream(instructions).startswith(b'1 -2 3.5')
+
+
 def test_unparse_interpret_operator():
     commands = []
     matrix = [2, 0, 0, 2, 0, 0]
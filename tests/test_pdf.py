@@ -311,6 +311,54 @@ def test_check(resources):
         assert 'parse error while reading' in problems[0]
 
 
+def _save_pdf_with_bad_streams(path, count):
+    with Pdf.new() as pdf:
+        for n in range(count):
+            pdf.add_blank_page()
+            pdf.pages[n].Contents = Stream(pdf, b'not flate data %d' % n)
+            pdf.pages[n].Contents.Filter = Name.FlateDecode
+        pdf.save(path)
+
+
+def test_check_parallel(outdir):
+    _save_pdf_with_bad_streams(outdir / 'bad_streams.pdf', 5)
+    with pikepdf.open(outdir / 'bad_streams.pdf') as pdf:
+        bad_objgens = sorted(page.Contents.objgen for page in pdf.pages)
+        problems = pdf._decode_streams_parallel(3)
+        assert sorted({objgen for objgen, _msg in problems}) == bad_objgens
+        assert len(pdf.get_warnings()) == len(problems)
+
+    with pikepdf.open(outdir / 'bad_streams.pdf') as pdf:
+        serial = pdf.check()
+    with pikepdf.open(outdir / 'bad_streams.pdf') as pdf:
+        parallel = pdf.check(workers=4)
+    assert len(serial) > 0 and len(parallel) > 0
+    assert all(prob.startswith('WARNING: ') for prob in parallel)
+
+
+def test_check_parallel_clean_file(resources):
+    with pikepdf.open(resources / 'sandwich.pdf') as pdf:
+        assert pdf._has_source_file
+        assert pdf._decode_streams_parallel(4) == []
+
+
+def test_check_parallel_needs_source_file(resources):
+    with Pdf.new() as pdf:
+        assert not pdf._has_source_file
+        with pytest.raises(ValueError):
+            pdf._decode_streams_parallel(2)
+        assert pdf.check(workers=2) == []
+    with open(resources / 'pal.pdf', 'rb') as f, pikepdf.open(f) as pdf:
+        assert not pdf._has_source_file
+
+
+def test_check_parallel_encrypted_is_serial(resources):
+    # The password is not kept after opening, so there is no view to reopen
+    with pikepdf.open(resources / 'graph-encrypted.pdf', password='owner') as pdf:
+        assert not pdf._has_source_file
+        assert pdf.check(workers=2) == pdf.check()
+
+
 def test_repr(trivial):
     assert repr(trivial).startswith('<')
 
@@ -350,6 +398,252 @@ def test_flate_compression_level():
         pikepdf._qpdf.set_flate_compression_level(-1)
 
 
+def _save_with_workers(path, workers, **kwargs):
+    out = BytesIO()
+    with pikepdf.open(path) as pdf:
+        pdf.save(out, static_id=True, workers=workers, **kwargs)
+    return out.getvalue()
+
+
+def test_save_workers_deterministic(resources):
+    path = resources / 'graph.pdf'
+    serial = _save_with_workers(path, 1, recompress_flate=True)
+    assert _save_with_workers(path, 4, recompress_flate=True) == serial
+
+    with pikepdf.open(path) as original, pikepdf.open(BytesIO(serial)) as saved:
+        for page, saved_page in zip(original.pages, saved.pages):
+            page.contents_coalesce()
+            saved_page.contents_coalesce()
+            assert page.Contents.read_bytes() == saved_page.Contents.read_bytes()
+
+
+def test_save_workers_compression_level(resources):
+    path = resources / 'graph.pdf'
+    try:
+        pikepdf._qpdf.set_flate_compression_level(0)
+        stored = _save_with_workers(path, 2, recompress_flate=True)
+    finally:
+        pikepdf._qpdf.set_flate_compression_level(-1)
+    assert len(_save_with_workers(path, 2, recompress_flate=True)) < len(stored)
+
+
+def test_save_workers_new_streams():
+    pdf = pikepdf.new()
+    pdf.add_blank_page()
+    pdf.pages[0].Contents = Stream(pdf, b'0 0 m 10 10 l S ' * 100)
+    out = BytesIO()
+    pdf.save(out, workers=2)
+    assert Name.Filter not in pdf.pages[0].Contents
+    assert pdf.pages[0].Contents.read_raw_bytes() == b'0 0 m 10 10 l S ' * 100
+    with pikepdf.open(out) as saved:
+        contents = saved.pages[0].Contents
+        assert contents.Filter == Name.FlateDecode
+        assert contents.read_bytes() == b'0 0 m 10 10 l S ' * 100
+
+
+def test_save_workers_restores_streams(resources):
+    with pikepdf.open(resources / 'graph.pdf') as pdf:
+        streams = [obj for obj in pdf.objects if isinstance(obj, Stream)]
+        before = [(dict(obj.stream_dict), obj.read_raw_bytes()) for obj in streams]
+        pdf.save(BytesIO(), workers=2, recompress_flate=True)
+        after = [(dict(obj.stream_dict), obj.read_raw_bytes()) for obj in streams]
+        assert after == before
+
+
+def test_save_workers_keeps_providers():
+    pdf = pikepdf.new()
+    pdf.add_blank_page()
+    calls = 0
+
+    def chunks():
+        nonlocal calls
+        calls += 1
+        yield b'0 0 m 10 10 l S ' * 100
+
+    pdf.pages[0].Contents = Stream(pdf, b'')
+    pdf.pages[0].Contents.write_from(chunks)
+    pdf.save(BytesIO(), workers=2)
+    assert calls == 1
+    assert Name.Filter not in pdf.pages[0].Contents
+    assert pdf.pages[0].Contents.read_bytes() == b'0 0 m 10 10 l S ' * 100
+    assert calls == 2
+
+
+def test_save_workers_metadata_uncompressed():
+    pdf = pikepdf.new()
+    xml = b'<?xpacket begin="" id="W5M0MpCehiHzreSzNTczkc9d"?><x:xmpmeta/>'
+    pdf.Root.Metadata = Stream(
+        pdf,
+        zlib.compress(xml),
+        Type=Name.Metadata,
+        Subtype=Name.XML,
+        Filter=Name.FlateDecode,
+    )
+    out = BytesIO()
+    pdf.save(out, workers=2)
+    with pikepdf.open(out) as saved:
+        assert Name.Filter not in saved.Root.Metadata
+        assert saved.Root.Metadata.read_raw_bytes() == xml
+
+
+@pytest.mark.parametrize(
+    'kwargs',
+    [
+        dict(workers=0),
+        dict(workers=2, qdf=True),
+        dict(workers=2, normalize_content=True),
+        dict(workers=2, encryption=pikepdf.Encryption(owner='o', user='u')),
+    ],
+)
+def test_save_workers_invalid(trivial, kwargs):
+    with pytest.raises(ValueError):
+        trivial.save(BytesIO(), **kwargs)
+
+
+class TestIncrementalSave:
+    @pytest.fixture
+    def source(self, resources, outdir):
+        path = outdir / 'source.pdf'
+        shutil.copy(resources / 'fourpages.pdf', path)
+        return path
+
+    def test_appends_changes(self, source, outdir):
+        original = source.read_bytes()
+        with pikepdf.open(source) as pdf:
+            pdf.pages[0].MediaBox[2] = 500
+            pdf.Root.Marker = pdf.make_indirect(pikepdf.Dictionary(Value=1))
+            pdf.save(outdir / 'out.pdf', incremental=True)
+        output = (outdir / 'out.pdf').read_bytes()
+        assert output.startswith(original)
+        # The page, the catalog and the new object
+        assert output[len(original) :].count(b' obj\n') == 3
+        with pikepdf.open(outdir / 'out.pdf') as pdf:
+            assert pdf.pages[0].MediaBox[2] == 500
+            assert pdf.Root.Marker.Value == 1
+            assert len(pdf.pages) == 4
+
+    def test_in_place(self, source):
+        size = source.stat().st_size
+        with pikepdf.open(source) as pdf:
+            pdf.pages[0].Contents.write(b'0 0 m 1 1 l S')
+            pdf.save(source, incremental=True)
+            pdf.pages[1].Rotate = 90
+            pdf.save(source, incremental=True)
+        assert source.stat().st_size > size
+        with pikepdf.open(source) as pdf:
+            assert pdf.pages[0].Contents.read_bytes() == b'0 0 m 1 1 l S'
+            assert pdf.pages[1].Rotate == 90
+
+    def test_unchanged(self, source):
+        out = BytesIO()
+        with pikepdf.open(source) as pdf:
+            pdf.save(out, incremental=True)
+        assert out.getvalue() == source.read_bytes()
+
+    def test_xref_stream(self, source, outdir):
+        with pikepdf.open(source) as pdf:
+            pdf.save(
+                outdir / 'objstm.pdf',
+                object_stream_mode=pikepdf.ObjectStreamMode.generate,
+            )
+        with pikepdf.open(outdir / 'objstm.pdf') as pdf:
+            pdf.Root.Marker = True
+            pdf.save(outdir / 'out.pdf', incremental=True)
+        with pikepdf.open(outdir / 'out.pdf') as pdf:
+            assert pdf.Root.Marker
+            assert len(pdf.pages) == 4
+
+    def test_needs_file(self):
+        with pytest.raises(ValueError):
+            pikepdf.new().save(BytesIO(), incremental=True)
+
+    def test_invalid_options(self, source, outdir):
+        with pikepdf.open(source) as pdf, pytest.raises(ValueError):
+            pdf.save(outdir / 'out.pdf', incremental=True, linearize=True)
+
+
+class TestChangeJournal:
+    def test_records_changes(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf:
+            assert pdf.get_changes() == dict(
+                created=[], modified=[], deleted=[], incomplete=False
+            )
+            page = pdf.pages[0].obj
+            page.Rotate = 90
+            del pdf.Root.Pages.Count
+            new = pdf.make_indirect(pikepdf.Dictionary(Value=1))
+            new.Value = 2  # Still only created
+            stream = Stream(pdf, b'data')
+
+            changes = pdf.get_changes()
+            assert changes['created'] == sorted([new.objgen, stream.objgen])
+            assert changes['modified'] == sorted(
+                [page.objgen, pdf.Root.Pages.objgen]
+            )
+            assert changes['deleted'] == []
+            assert pdf.is_changed(page.objgen)
+            assert not pdf.is_changed(pdf.pages[1].objgen)
+
+    def test_write_and_replace(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf:
+            contents = pdf.pages[0].Contents
+            contents.write(b'q Q')
+            pdf.pages[1].MediaBox[2] = 500  # Direct array, found by comparison
+            temporary = pdf.make_indirect(pikepdf.Dictionary())
+            pdf._replace_object(temporary.objgen, pikepdf.Object.parse(b'null'))
+            page_objgen = pdf.pages[2].obj.objgen
+            pdf._replace_object(page_objgen, pikepdf.Object.parse(b'null'))
+
+            changes = pdf.get_changes()
+            assert changes['modified'] == sorted(
+                [contents.objgen, pdf.pages[1].objgen]
+            )
+            assert changes['created'] == []
+            assert changes['deleted'] == [page_objgen]
+            assert not changes['incomplete']
+
+    def test_checkpoint(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf:
+            pdf.pages[0].Rotate = 90
+            pdf.checkpoint()
+            assert not pdf.is_changed(pdf.pages[0].objgen)
+            pdf.pages[1].Rotate = 90
+            assert pdf.get_changes()['modified'] == [pdf.pages[1].objgen]
+
+    def test_checkpoint_keeps_watching(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf:
+            mediabox = pdf.pages[0].MediaBox
+            pdf.checkpoint()
+            mediabox[2] = 500
+            assert pdf.get_changes()['modified'] == [pdf.pages[0].objgen]
+
+    def test_pages_and_copies(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf, pikepdf.open(
+            resources / 'graph.pdf'
+        ) as other:
+            pages_objgen = pdf.Root.Pages.objgen
+            del pdf.pages[0]
+            assert pdf.get_changes()['modified'] == [pages_objgen]
+
+            pdf.checkpoint()
+            pdf.pages.append(other.pages[0])
+            changes = pdf.get_changes()
+            assert pdf.pages[-1].objgen in changes['created']
+            assert pdf.pages[-1].Contents.objgen in changes['created']
+            assert changes['modified'] == [pages_objgen]
+
+            pdf.checkpoint()
+            info = pdf.copy_foreign(other.trailer.Info)
+            assert pdf.get_changes()['created'] == [info.objgen]
+
+    def test_incomplete(self, resources):
+        with pikepdf.open(resources / 'fourpages.pdf') as pdf:
+            pdf.remove_unreferenced_resources()
+            assert pdf.get_changes()['incomplete']
+            pdf.checkpoint()
+            assert not pdf.get_changes()['incomplete']
+
+
 def test_set_access_default_mmap():
     initial = pikepdf._qpdf.get_access_default_mmap()
     try:
@@ -384,3 +678,99 @@ def test_flatten_annotations_parameters(pdf_form, mode, exc):
             pdf_form.flatten_annotations()
         else:
             pdf_form.flatten_annotations(mode)
+
+
+class TestOpenMany:
+    NAMES = ['pal.pdf', 'fourpages.pdf', 'sandwich.pdf', 'graph.pdf', 'outlines.pdf']
+
+    def test_open_many(self, resources, outdir):
+        empty = outdir / 'empty.pdf'
+        empty.touch()
+        paths = [resources / name for name in self.NAMES]
+        paths += [outdir / 'missing.pdf', empty, resources / 'graph-encrypted.pdf']
+
+        results = {r.path: r for r in pikepdf.open_many(paths, workers=4)}
+        assert set(results) == set(paths)
+
+        for name in self.NAMES:
+            result = results[resources / name]
+            assert result.error is None
+            with Pdf.open(resources / name) as expected, result.pdf as pdf:
+                assert len(pdf.pages) == len(expected.pages)
+                assert pdf.filename == expected.filename
+
+        assert results[outdir / 'missing.pdf'].pdf is None
+        assert isinstance(results[outdir / 'missing.pdf'].error, FileNotFoundError)
+        assert isinstance(results[empty].error, PdfError)
+        assert isinstance(results[resources / 'graph-encrypted.pdf'].error, PasswordError)
+
+    def test_open_many_password(self, resources):
+        (result,) = pikepdf.open_many(
+            [resources / 'graph-encrypted.pdf'], password='owner'
+        )
+        with result.pdf as pdf:
+            assert pdf.is_encrypted
+
+    def test_open_many_check(self, outdir):
+        _save_pdf_with_bad_streams(outdir / 'bad_stream.pdf', 1)
+
+        (unchecked,) = pikepdf.open_many([outdir / 'bad_stream.pdf'], check=False)
+        (checked,) = pikepdf.open_many([outdir / 'bad_stream.pdf'], check=True)
+        assert not unchecked.pdf.get_warnings()
+        assert checked.pdf.get_warnings()
+
+    def test_open_many_stop_early(self, resources):
+        paths = [resources / name for name in self.NAMES] * 4
+        results = pikepdf.open_many(paths, workers=2)
+        first = next(results)
+        assert first.pdf is not None
+        results.close()
+
+    def test_open_many_slow_consumer(self, resources):
+        # Workers wait for results to be taken once they are two files ahead
+        paths = [resources / name for name in self.NAMES] * 3
+        opened = []
+        for result in pikepdf.open_many(paths, workers=1):
+            with result.pdf as pdf:
+                opened.append((result.path, len(pdf.pages)))
+        assert sorted(path for path, _ in opened) == sorted(paths)
+
+    def test_open_many_bad_workers(self, resources):
+        with pytest.raises(ValueError):
+            list(pikepdf.open_many([resources / 'pal.pdf'], workers=0))
+        assert list(pikepdf.open_many([])) == []
+
+
+class TestProbe:
+    @pytest.mark.parametrize('name', ['fourpages.pdf', 'sandwich.pdf', 'graph.pdf'])
+    def test_probe_matches_open(self, resources, name):
+        info = pikepdf.probe(resources / name)
+        with Pdf.open(resources / name) as pdf:
+            assert info.path == resources / name
+            assert info.page_count == len(pdf.pages)
+            assert info.pdf_version == pdf.pdf_version
+            assert info.is_encrypted == pdf.is_encrypted
+            assert info.is_linearized == pdf.is_linearized
+            assert set(info.docinfo) == set(pdf.docinfo.keys())
+            for key, value in pdf.docinfo.items():
+                if isinstance(value, pikepdf.String):
+                    assert info.docinfo[key] == str(value)
+            if Name.Metadata in pdf.Root:
+                assert info.xmp == pdf.Root.Metadata.read_bytes()
+            else:
+                assert info.xmp is None
+
+    def test_probe_encrypted(self, resources):
+        info = pikepdf.probe(resources / 'graph-encrypted.pdf')
+        assert info.is_encrypted
+        assert not info.password_correct
+        assert info.page_count is None
+
+        info = pikepdf.probe(resources / 'graph-encrypted.pdf', password='owner')
+        assert info.is_encrypted and info.password_correct
+        with Pdf.open(resources / 'graph-encrypted.pdf', password='owner') as pdf:
+            assert info.page_count == len(pdf.pages)
+
+    def test_probe_missing(self, outdir):
+        with pytest.raises(FileNotFoundError):
+            pikepdf.probe(outdir / 'missing.pdf')